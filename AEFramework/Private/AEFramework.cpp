@@ -3,6 +3,7 @@
 //Including these for linker reasons, having a cpp file include them forces them to compile properly
 #include "AERandomList.h"
 #include "AERandomBuckets.h"
+#include "AEStateMachine.h"
 
 /**
 Workaround for running standalone game from editor.
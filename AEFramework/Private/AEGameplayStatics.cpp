@@ -4,9 +4,14 @@
 #include "Animation/AnimMontage.h"
 #include "Animation/AnimInstance.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
 
 #include "AELogging.h"
+#include "AEEventLog.h"
 #include "AEPhysicalActor.h"
+#include "AEActorStateBatcher.h"
+#include "AEActorDestructionQueue.h"
 
 ////////////////////////////////////
 //Animation
@@ -36,70 +41,30 @@ FAnimMontageInstance * PlayMontageWithDuration(UAnimMontage * Montage, UAnimInst
 ////////////////////////////////////
 //Utility
 
-/**
-Helper for traversing attached actors heirarchy and calls a lambda on them.
-Have the lambda return false to stop traversal.
-*/
-void AttachedActorsHelper(AActor * Actor, USceneComponent * Component, std::function<bool(AActor *)> Func)
+void UAEGameplayStatics::DestroyAttachedActors(AActor * Actor)
 {
-    if (Component)
-    {
-        if (Component->GetOwner() != Actor)
-        {
-			if (Func(Component->GetOwner()))
-			{
-				AttachedActorsHelper(Component->GetOwner(), Component, Func);
-			}
-            return;
-        }
-
-        for (int32 ChildInd = 0; ChildInd < Component->GetAttachChildren().Num(); ++ChildInd)
+    AttachedActorsHelper(Actor, Actor->GetRootComponent(), 
+        [](AActor * Actor)
         {
-            AttachedActorsHelper(Actor, Component->GetAttachChildren()[ChildInd], Func);
-        }
-    }
+            Actor->Destroy(); 
+			return true;
+        });
 }
 
-void LevelComponentsTraverser(USceneComponent * Component, std::function<bool(USceneComponent *)> Func)
+void UAEGameplayStatics::DestroyAttachedActorsDeferred(AActor * Actor)
 {
-	if (!Component)
+	AAEActorDestructionQueue * DestructionQueue = AAEActorDestructionQueue::Get(Actor->GetWorld());
+
+	if (DestructionQueue)
 	{
-		return;
+		DestructionQueue->Enqueue(Actor, false);
 	}
-
-	TArray<USceneComponent *> LevelTraverseQueue;
-
-	LevelTraverseQueue.Add(Component);
-
-	while (LevelTraverseQueue.Num() > 0)
+	else
 	{
-		USceneComponent * CurrComp = LevelTraverseQueue[0];
-		LevelTraverseQueue.RemoveAt(0);
-
-		//Add children to queue
-		for (USceneComponent * Child : CurrComp->GetAttachChildren())
-		{
-			LevelTraverseQueue.Add(Child);
-		}
-
-		//call lambda for the component
-		if (Func(CurrComp))
-		{
-			return;
-		}
+		DestroyAttachedActors(Actor);
 	}
 }
 
-void UAEGameplayStatics::DestroyAttachedActors(AActor * Actor)
-{
-    AttachedActorsHelper(Actor, Actor->GetRootComponent(), 
-        [](AActor * Actor)
-        {
-            Actor->Destroy(); 
-			return true;
-        });
-}
-
 void UAEGameplayStatics::SetAttachedActorsHiddenInGame(AActor * Actor, bool bNewHidden)
 {
     AttachedActorsHelper(Actor, Actor->GetRootComponent(),
@@ -115,7 +80,7 @@ void UAEGameplayStatics::SetAttachedActorsHiddenInGame(AActor * Actor, bool bNew
 				}
 			}
 
-            Actor->SetActorHiddenInGame(bNewHidden);
+            AAEActorStateBatcher::RequestActorHiddenInGame(Actor, bNewHidden);
 			return true;
         });
 }
@@ -135,7 +100,7 @@ void UAEGameplayStatics::SetAttachedActorsEnableCollision(AActor * Actor, bool b
 			}
 		}
 
-		Actor->SetActorEnableCollision(bEnabled);
+		AAEActorStateBatcher::RequestActorEnableCollision(Actor, bEnabled);
 		return true;
 	});
 }
@@ -218,25 +183,409 @@ FTransform UAEGameplayStatics::LookatAroundTransform(const FTransform& OriginTra
 	return OriginAimedAtLocation;
 }
 
+/**
+The first component in level order under a root component that has each socket.
+*/
+struct FAESocketIndex
+{
+	uint32 AttachmentGeneration;
+
+	/**
+	Set when a lookup finds the index wrong, so it's rebuilt even if the heirarchy looks unchanged.
+	*/
+	bool bStale;
+
+	TMap<FName, TWeakObjectPtr<USceneComponent>> SocketComponents;
+
+	/**
+	Every component under the root when the index was built, and how many attach children each had.
+	When AttachmentGeneration changes because something attached elsewhere, comparing these is enough to keep the index,
+	so only the heirarchies that actually changed pay for querying sockets again.
+	*/
+	TArray<TWeakObjectPtr<USceneComponent>> Components;
+
+	TArray<int32> ChildCounts;
+
+	bool IsHeirarchyUnchanged() const
+	{
+		for (int32 ComponentInd = 0; ComponentInd < Components.Num(); ++ComponentInd)
+		{
+			const USceneComponent * Component = Components[ComponentInd].Get();
+
+			if (!Component || Component->GetAttachChildren().Num() != ChildCounts[ComponentInd])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+/**
+Socket indices by root component, game thread only.
+*/
+static TMap<TWeakObjectPtr<USceneComponent>, FAESocketIndex> GAESocketIndices;
+
+static int32 GAESocketIndicesPruneSize = 64;
+
+static FAESocketIndex& GetSocketIndex(USceneComponent * RootComponent)
+{
+	FAESocketIndex * Index = GAESocketIndices.Find(RootComponent);
+
+	if (!Index)
+	{
+		//drop indices of destroyed components every time the map doubles
+		if (GAESocketIndices.Num() >= GAESocketIndicesPruneSize)
+		{
+			for (auto It = GAESocketIndices.CreateIterator(); It; ++It)
+			{
+				if (!It.Key().IsValid())
+				{
+					It.RemoveCurrent();
+				}
+			}
+
+			GAESocketIndicesPruneSize = FMath::Max(64, GAESocketIndices.Num() * 2);
+		}
+
+		Index = &GAESocketIndices.Add(RootComponent);
+		Index->AttachmentGeneration = 0;
+		Index->bStale = true;
+	}
+
+	if (Index->AttachmentGeneration != AAEPhysicalActor::GetAttachmentGeneration())
+	{
+		Index->AttachmentGeneration = AAEPhysicalActor::GetAttachmentGeneration();
+
+		if (!Index->IsHeirarchyUnchanged())
+		{
+			Index->bStale = true;
+		}
+	}
+
+	if (Index->bStale)
+	{
+		Index->bStale = false;
+		Index->SocketComponents.Reset();
+		Index->Components.Reset();
+		Index->ChildCounts.Reset();
+
+		TArray<FComponentSocketDescription> Sockets;
+
+		TraverseComponents<AEComponentTraversalOrder::BREADTH_FIRST>(RootComponent, [Index, &Sockets](USceneComponent * Component)
+		{
+			Index->Components.Add(Component);
+			Index->ChildCounts.Add(Component->GetAttachChildren().Num());
+
+			if (Component->HasAnySockets())
+			{
+				Sockets.Reset();
+				Component->QuerySupportedSockets(Sockets);
+
+				for (const FComponentSocketDescription& Socket : Sockets)
+				{
+					if (!Index->SocketComponents.Contains(Socket.Name))
+					{
+						Index->SocketComponents.Add(Socket.Name, Component);
+					}
+				}
+			}
+
+			return false;
+		});
+	}
+
+	return *Index;
+}
+
 USceneComponent * UAEGameplayStatics::FindAttachedComponentWithSocket(USceneComponent * RootComponent, FName Socket)
 {
-	USceneComponent * Res = NULL;
+	if (RootComponent && Socket != NAME_None && IsInGameThread())
+	{
+		FAESocketIndex& Index = GetSocketIndex(RootComponent);
+
+		const TWeakObjectPtr<USceneComponent> * IndexedComponent = Index.SocketComponents.Find(Socket);
 
-	auto FindSocketCompFunc = [&Socket, &Res](USceneComponent * Component) -> bool
+		if (IndexedComponent && IndexedComponent->IsValid() && (*IndexedComponent)->DoesSocketExist(Socket)
+			&& (IndexedComponent->Get() == RootComponent || (*IndexedComponent)->IsAttachedTo(RootComponent)))
+		{
+			return IndexedComponent->Get();
+		}
+
+		//components, meshes, or attachments changed without an attachment notification, fall back to walking the heirarchy and reindex next time
+		USceneComponent * Res = TraverseComponents<AEComponentTraversalOrder::BREADTH_FIRST>(RootComponent, [Socket](USceneComponent * Component)
+		{
+			return Component->DoesSocketExist(Socket);
+		});
+
+		if (Res || IndexedComponent)
+		{
+			Index.bStale = true;
+		}
+
+		return Res;
+	}
+
+	return TraverseComponents<AEComponentTraversalOrder::BREADTH_FIRST>(RootComponent, [Socket](USceneComponent * Component)
+	{
+		return Component->DoesSocketExist(Socket);
+	});
+}
+
+struct FAESocketTransformKey
+{
+	TWeakObjectPtr<USceneComponent> RootComponent;
+
+	FName Socket;
+
+	/**
+	The socket scene component as passed in or as found by FindAttachedComponentWithSocket.
+	*/
+	TWeakObjectPtr<USceneComponent> SocketSceneComponent;
+
+	FORCEINLINE bool operator==(const FAESocketTransformKey& Other) const
+	{
+		return RootComponent == Other.RootComponent && Socket == Other.Socket && SocketSceneComponent == Other.SocketSceneComponent;
+	}
+
+	friend FORCEINLINE uint32 GetTypeHash(const FAESocketTransformKey& Key)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Key.RootComponent), GetTypeHash(Key.Socket)), GetTypeHash(Key.SocketSceneComponent));
+	}
+};
+
+/**
+Caches GetRelativeTransformToSocket results for rigid parts of a heirarchy, game thread only.
+
+The components between the socket scene component and the root component are the links of an entry.
+An entry is dropped when a movable link's transform updates for any reason other than its parent moving, which covers SetRelativeTransform.
+Each hit also checks that every link is still attached to the same parent and socket, and that a static mesh socket component still has the same mesh,
+so only the entries whose own links were reattached or swapped meshes are dropped, attaching anything else doesn't affect them.
+Results that can change without a transform update of a link aren't cached at all:
+sockets on skinned meshes, links attached to a skinned mesh socket or bone, links simulating physics,
+and links with absolute location, rotation or scale, which don't get a transform update when their parent moves.
+Entries are keyed by the resolved socket scene component, so sockets found by name are looked up again every call
+and the validation in GetRelativeTransformToSocket runs before the cache is checked.
+*/
+class FAESocketTransformCache
+{
+public:
+	bool Find(const FAESocketTransformKey& Key, FTransform& OutTransform)
 	{
-		if (Component->DoesSocketExist(Socket))
+		FEntry * Entry = Entries.Find(Key);
+
+		if (!Entry)
 		{
-			Res = Component;
-			return true;
+			return false;
+		}
+
+		if (!IsChainUnchanged(Key, *Entry))
+		{
+			Entries.Remove(Key);
+			return false;
+		}
+
+		OutTransform = Entry->RelativeTransform;
+		return true;
+	}
+
+	void Add(const FAESocketTransformKey& Key, USceneComponent * RootComponent, FName Socket, USceneComponent * SocketSceneComponent, const FTransform& RelativeTransform)
+	{
+		UWorld * World = RootComponent->GetWorld();
+
+		if (!World || !World->IsGameWorld())
+		{
+			return;
+		}
+
+		if (Socket != NAME_None && SocketSceneComponent->IsA<USkinnedMeshComponent>())
+		{
+			return;
+		}
+
+		TArray<USceneComponent *, TInlineAllocator<8>> Chain;
+		TArray<USceneComponent *, TInlineAllocator<8>> MovableLinks;
+
+		for (USceneComponent * Link = SocketSceneComponent; Link != RootComponent; Link = Link->GetAttachParent())
+		{
+			//not under the root component, the result depends on components outside the chain
+			if (!Link)
+			{
+				return;
+			}
+
+			if (Link->IsSimulatingPhysics())
+			{
+				return;
+			}
+
+			if (Link->bAbsoluteLocation || Link->bAbsoluteRotation || Link->bAbsoluteScale)
+			{
+				return;
+			}
+
+			if (Link->GetAttachSocketName() != NAME_None && Link->GetAttachParent() && Link->GetAttachParent()->IsA<USkinnedMeshComponent>())
+			{
+				return;
+			}
+
+			Chain.Add(Link);
+
+			if (Link->Mobility != EComponentMobility::Static)
+			{
+				MovableLinks.Add(Link);
+			}
+		}
+
+		PruneIfNeeded();
+
+		FEntry& Entry = Entries.Add(Key);
+		Entry.RelativeTransform = RelativeTransform;
+		Entry.SocketMesh = GetSocketMesh(SocketSceneComponent);
+		Entry.Chain.Reset();
+
+		for (USceneComponent * Link : Chain)
+		{
+			FChainLink& ChainLink = Entry.Chain[Entry.Chain.AddDefaulted()];
+			ChainLink.Component = Link;
+			ChainLink.AttachParent = Link->GetAttachParent();
+			ChainLink.AttachSocketName = Link->GetAttachSocketName();
 		}
 
-		return false;
+		for (USceneComponent * Link : MovableLinks)
+		{
+			FLink& LinkInfo = Links.FindOrAdd(Link);
+
+			if (!LinkInfo.TransformUpdatedHandle.IsValid())
+			{
+				LinkInfo.TransformUpdatedHandle = Link->TransformUpdated.AddRaw(this, &FAESocketTransformCache::OnLinkTransformUpdated);
+			}
+
+			LinkInfo.Dependents.AddUnique(Key);
+		}
+	}
+
+private:
+	struct FChainLink
+	{
+		TWeakObjectPtr<USceneComponent> Component;
+
+		TWeakObjectPtr<USceneComponent> AttachParent;
+
+		FName AttachSocketName;
 	};
 
-	LevelComponentsTraverser(RootComponent, FindSocketCompFunc);
+	struct FEntry
+	{
+		FTransform RelativeTransform;
 
-	return Res;
-}
+		/**
+		Links from the socket scene component up to, not including, the root component, and what each was attached to.
+		*/
+		TArray<FChainLink, TInlineAllocator<4>> Chain;
+
+		/**
+		Mesh of a static mesh socket scene component, its sockets change with the mesh.
+		*/
+		TWeakObjectPtr<UObject> SocketMesh;
+	};
+
+	static UObject * GetSocketMesh(USceneComponent * SocketSceneComponent)
+	{
+		UStaticMeshComponent * StaticMeshComponent = Cast<UStaticMeshComponent>(SocketSceneComponent);
+
+		return StaticMeshComponent ? StaticMeshComponent->GetStaticMesh() : NULL;
+	}
+
+	/**
+	Walks the recorded chain, which is only a few parent pointers compared to recomputing the socket transforms.
+	*/
+	static bool IsChainUnchanged(const FAESocketTransformKey& Key, const FEntry& Entry)
+	{
+		if (!Key.RootComponent.IsValid() || !Key.SocketSceneComponent.IsValid())
+		{
+			return false;
+		}
+
+		for (const FChainLink& ChainLink : Entry.Chain)
+		{
+			USceneComponent * Link = ChainLink.Component.Get();
+
+			if (!Link || Link->GetAttachParent() != ChainLink.AttachParent.Get() || Link->GetAttachSocketName() != ChainLink.AttachSocketName)
+			{
+				return false;
+			}
+		}
+
+		return GetSocketMesh(Key.SocketSceneComponent.Get()) == Entry.SocketMesh.Get();
+	}
+
+	struct FLink
+	{
+		FDelegateHandle TransformUpdatedHandle;
+
+		TArray<FAESocketTransformKey, TInlineAllocator<2>> Dependents;
+	};
+
+	void OnLinkTransformUpdated(USceneComponent * Link, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+	{
+		//the parent moved, relative transforms below it didn't change
+		if (EnumHasAnyFlags(UpdateTransformFlags, EUpdateTransformFlags::PropagateFromParent))
+		{
+			return;
+		}
+
+		FLink LinkInfo;
+
+		if (Links.RemoveAndCopyValue(Link, LinkInfo))
+		{
+			Link->TransformUpdated.Remove(LinkInfo.TransformUpdatedHandle);
+
+			for (const FAESocketTransformKey& Dependent : LinkInfo.Dependents)
+			{
+				Entries.Remove(Dependent);
+			}
+		}
+	}
+
+	/**
+	Drops entries and links of destroyed components every time the cache doubles.
+	*/
+	void PruneIfNeeded()
+	{
+		if (Entries.Num() < PruneSize)
+		{
+			return;
+		}
+
+		for (auto It = Entries.CreateIterator(); It; ++It)
+		{
+			if (!IsChainUnchanged(It.Key(), It.Value()))
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		for (auto It = Links.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		PruneSize = FMath::Max(256, Entries.Num() * 2);
+	}
+
+	TMap<FAESocketTransformKey, FEntry> Entries;
+
+	TMap<TWeakObjectPtr<USceneComponent>, FLink> Links;
+
+	int32 PruneSize = 256;
+};
+
+static FAESocketTransformCache GAESocketTransformCache;
 
 FTransform UAEGameplayStatics::GetRelativeTransformToSocket(USceneComponent * RootComponent, FName Socket, USceneComponent * SocketSceneComponent)
 {
@@ -244,7 +593,7 @@ FTransform UAEGameplayStatics::GetRelativeTransformToSocket(USceneComponent * Ro
 
 	if (!RootComponent)
 	{
-		UE_LOG_ON_SCREEN(AE, Error, 5.f, FColor::Red,
+		AE_LOG_ON_SCREEN(AE, Error, 5.f, FColor::Red,
 			TEXT("GetRelativeTransformToSocket passed NULL RootComponent."));
 
 		return Res;
@@ -256,7 +605,7 @@ FTransform UAEGameplayStatics::GetRelativeTransformToSocket(USceneComponent * Ro
 		//This isn't a fatal error though so don't return.
 		if (Socket != NAME_None && !SocketSceneComponent->DoesSocketExist(Socket))
 		{
-			UE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Yellow,
+			AE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Yellow,
 				TEXT("GetRelativeTransformToSocket passed RootComponent \"%s\" and Socket \"%s\" and SocketSceneComponent \"%s\" but the socket isn't found on SocketSceneComponent."),
 				*RootComponent->GetName(),
 				*Socket.ToString(),
@@ -266,7 +615,7 @@ FTransform UAEGameplayStatics::GetRelativeTransformToSocket(USceneComponent * Ro
 		//check that they're both in the same actor
 		if (RootComponent != SocketSceneComponent && (RootComponent->GetOwner() != SocketSceneComponent->GetOwner() || !RootComponent->GetOwner() || !SocketSceneComponent->GetOwner()))
 		{
-			UE_LOG_ON_SCREEN(AE, Error, 5.f, FColor::Red,
+			AE_LOG_ON_SCREEN(AE, Error, 5.f, FColor::Red,
 				TEXT("GetRelativeTransformToSocket passed RootComponent \"%s\" with owner \"%s\" and SocketSceneComponent \"%s\" with owner \"%s\".  They need to have the same owner actor and be in the same heirarchy and belong to a non NULL actor."),
 				*RootComponent->GetName(),
 				RootComponent->GetOwner()
@@ -295,7 +644,7 @@ FTransform UAEGameplayStatics::GetRelativeTransformToSocket(USceneComponent * Ro
 
 			if (!SocketSceneComponent)
 			{
-				UE_LOG_ON_SCREEN(AE, Error, 5.f, FColor::Red,
+				AE_LOG_ON_SCREEN(AE, Error, 5.f, FColor::Red,
 					TEXT("GetRelativeTransformToSocket passed RootComponent \"%s\" and Socket \"%s\" and this socket hasn't been found anywhere in the heirarchy of attached components."),
 					*RootComponent->GetName(),
 					*Socket.ToString());
@@ -304,6 +653,18 @@ FTransform UAEGameplayStatics::GetRelativeTransformToSocket(USceneComponent * Ro
 			}
 		}
 	}
+
+	const bool bUseCache = IsInGameThread();
+
+	FAESocketTransformKey CacheKey;
+	CacheKey.RootComponent = RootComponent;
+	CacheKey.Socket = Socket;
+	CacheKey.SocketSceneComponent = SocketSceneComponent;
+
+	if (bUseCache && GAESocketTransformCache.Find(CacheKey, Res))
+	{
+		return Res;
+	}
 	
 	if (Socket != NAME_None)
 	{
@@ -315,6 +676,11 @@ FTransform UAEGameplayStatics::GetRelativeTransformToSocket(USceneComponent * Ro
 		Res = Res * SocketSceneComponent->GetComponentTransform().GetRelativeTransform(RootComponent->GetComponentTransform());
 	}
 
+	if (bUseCache)
+	{
+		GAESocketTransformCache.Add(CacheKey, RootComponent, Socket, SocketSceneComponent, Res);
+	}
+
 	return Res;
 }
 
@@ -338,42 +704,185 @@ void UAEGameplayStatics::AttachComponentToComponent(USceneComponent * Child, USc
 	USceneComponent * ChildSocketSceneComponent,
 	bool bWeldSimulatedBodies)
 {
-	if (Child && Parent)
+	FAEAttachRequest Request;
+	Request.Child = Child;
+	Request.Parent = Parent;
+	Request.ParentSocketName = ParentSocketName;
+	Request.ChildSocketName = ChildSocketName;
+	Request.ParentSocketSceneComponent = ParentSocketSceneComponent;
+	Request.ChildSocketSceneComponent = ChildSocketSceneComponent;
+	Request.bWeldSimulatedBodies = bWeldSimulatedBodies;
+
+	AttachComponentsToComponent(TArrayView<const FAEAttachRequest>(&Request, 1));
+}
+
+/**
+Whether resolving a socket of an attach request would give a different result once the pending children of the batch are attached.
+That's the case when the socket scene component is below a pending child,
+or when the socket is looked up by name, isn't found yet and a pending child is being attached somewhere in Root's heirarchy.
+*/
+static bool AttachSocketDependsOnPending(USceneComponent * Root, FName SocketName, USceneComponent * SocketSceneComponent,
+	const TSet<USceneComponent *>& PendingChildren,
+	const TSet<USceneComponent *>& PendingParentHeirarchy)
+{
+	if (!SocketSceneComponent)
 	{
-		if (!ParentSocketSceneComponent && ParentSocketName != NAME_None)
+		if (SocketName == NAME_None)
 		{
-			ParentSocketSceneComponent = FindAttachedComponentWithSocket(Parent, ParentSocketName);
+			return false;
 		}
-		
+
+		SocketSceneComponent = UAEGameplayStatics::FindAttachedComponentWithSocket(Root, SocketName);
+
+		if (!SocketSceneComponent)
+		{
+			return PendingParentHeirarchy.Contains(Root);
+		}
+	}
+
+	for (USceneComponent * Link = SocketSceneComponent; Link && Link != Root; Link = Link->GetAttachParent())
+	{
+		if (PendingChildren.Contains(Link))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UAEGameplayStatics::AttachComponentsToComponent(TArrayView<const FAEAttachRequest> Requests)
+{
+	struct FResolvedAttachment
+	{
+		const FAEAttachRequest * Request;
+		FName AttachSocketName;
+		FTransform RelativeTransform;
+	};
+
+	TArray<FResolvedAttachment, TInlineAllocator<16>> Resolved;
+
+	//resolved attachments from NumAttached on haven't been attached yet
+	int32 NumAttached = 0;
+
+	//children of the resolved attachments that haven't been attached yet, and their parents and everything those are attached to
+	TSet<USceneComponent *> PendingChildren;
+	TSet<USceneComponent *> PendingParentHeirarchy;
+
+	//attach with the final relative transform already set so each child's transform only updates once
+	auto AttachPending = [&Resolved, &NumAttached, &PendingChildren, &PendingParentHeirarchy]()
+	{
+		PendingChildren.Reset();
+		PendingParentHeirarchy.Reset();
+
+		for (; NumAttached < Resolved.Num(); ++NumAttached)
+		{
+			const FResolvedAttachment& Attachment = Resolved[NumAttached];
+			USceneComponent * Child = Attachment.Request->Child;
+
+			if (Child->GetAttachParent() == Attachment.Request->Parent && Child->GetAttachSocketName() == Attachment.AttachSocketName)
+			{
+				//already attached there, attaching again wouldn't update the transform
+				Child->SetRelativeTransform(Attachment.RelativeTransform);
+			}
+			else
+			{
+				//attaching detaches from the old parent keeping the world transform, which would overwrite the relative transform set below
+				if (Child->GetAttachParent())
+				{
+					Child->DetachFromComponent(FDetachmentTransformRules::KeepRelativeTransform);
+				}
+
+				Child->RelativeLocation = Attachment.RelativeTransform.GetLocation();
+				Child->RelativeRotation = Attachment.RelativeTransform.Rotator();
+				Child->RelativeScale3D = Attachment.RelativeTransform.GetScale3D();
+
+				Child->AttachToComponent(Attachment.Request->Parent, FAttachmentTransformRules::KeepRelativeTransform, Attachment.AttachSocketName);
+			}
+		}
+	};
+
+	for (const FAEAttachRequest& Request : Requests)
+	{
+		if (!Request.Child || !Request.Parent)
+		{
+			AE_LOG_ON_SCREEN(AE, Error, 5.f, FColor::Red,
+				TEXT("AttachComponentsToComponent passed Child \"%s\" and Parent \"%s\".  Both need to be not NULL."),
+				Request.Child
+					? *Request.Child->GetName()
+					: TEXT("NULL"),
+
+				Request.Parent
+					? *Request.Parent->GetName()
+					: TEXT("NULL"));
+
+			continue;
+		}
+
+		//requests are resolved up front so children are attached together, unless this one's sockets or offsets
+		//depend on where an earlier child ends up, like a socket on a scope that's attached in the same batch
+		if (PendingChildren.Num() > 0
+			&& (AttachSocketDependsOnPending(Request.Parent, Request.ParentSocketName, Request.ParentSocketSceneComponent, PendingChildren, PendingParentHeirarchy)
+				|| AttachSocketDependsOnPending(Request.Child, Request.ChildSocketName, Request.ChildSocketSceneComponent, PendingChildren, PendingParentHeirarchy)))
+		{
+			AttachPending();
+			AAEPhysicalActor::NotifyAttachmentChanged();
+		}
+
+		USceneComponent * ParentSocketSceneComponent = Request.ParentSocketSceneComponent;
+
+		if (!ParentSocketSceneComponent && Request.ParentSocketName != NAME_None)
+		{
+			ParentSocketSceneComponent = FindAttachedComponentWithSocket(Request.Parent, Request.ParentSocketName);
+		}
+
+		FResolvedAttachment& Attachment = Resolved[Resolved.AddUninitialized()];
+		Attachment.Request = &Request;
+
+		PendingChildren.Add(Request.Child);
+
+		for (USceneComponent * Link = Request.Parent; Link; Link = Link->GetAttachParent())
+		{
+			bool bAlreadyInHeirarchy = false;
+			PendingParentHeirarchy.Add(Link, &bAlreadyInHeirarchy);
+
+			//the rest of the way up was added by an earlier request
+			if (bAlreadyInHeirarchy)
+			{
+				break;
+			}
+		}
+
 		//if we can, just attach the component to the parent's socket directly
-		Child->AttachToComponent(Parent,
-			FAttachmentTransformRules(EAttachmentRule::SnapToTarget, bWeldSimulatedBodies), 
-			ParentSocketSceneComponent == Parent ? ParentSocketName : NAME_None);
-				
+		Attachment.AttachSocketName = ParentSocketSceneComponent == Request.Parent ? Request.ParentSocketName : NAME_None;
+
 		FTransform RelTransform = FTransform::Identity;
 
 		//find relative transform between Parent and ParentSocketSceneComponent Socket
-		if (ParentSocketSceneComponent != Parent
-			&& (ParentSocketSceneComponent || ParentSocketName != NAME_None))
+		if (ParentSocketSceneComponent != Request.Parent
+			&& (ParentSocketSceneComponent || Request.ParentSocketName != NAME_None))
 		{
-			RelTransform = RelTransform * GetRelativeTransformToSocket(Parent, ParentSocketName, ParentSocketSceneComponent);
+			RelTransform = RelTransform * GetRelativeTransformToSocket(Request.Parent, Request.ParentSocketName, ParentSocketSceneComponent);
 		}
 
-		RelTransform = GetRelativeTransformToSocket(Child, ChildSocketName, ChildSocketSceneComponent).Inverse() * RelTransform;
-		
-		Child->SetRelativeTransform(RelTransform);
+		Attachment.RelativeTransform = GetRelativeTransformToSocket(Request.Child, Request.ChildSocketName, Request.ChildSocketSceneComponent).Inverse() * RelTransform;
 	}
-	else
+
+	AttachPending();
+
+	for (const FResolvedAttachment& Attachment : Resolved)
 	{
-		UE_LOG_ON_SCREEN(AE, Error, 5.f, FColor::Red,
-			TEXT("AttachComponentToComponent passed Child \"%s\" and Parent \"%s\".  Both need to be not NULL."),
-			Child
-				? *Child->GetName()
-				: TEXT("NULL"),
+		UPrimitiveComponent * ChildPrimitive = Cast<UPrimitiveComponent>(Attachment.Request->Child);
 
-			Parent
-				? *Parent->GetName()
-				: TEXT("NULL"));
+		if (Attachment.Request->bWeldSimulatedBodies && ChildPrimitive)
+		{
+			ChildPrimitive->WeldTo(Attachment.Request->Parent, Attachment.AttachSocketName);
+		}
+	}
+
+	if (Resolved.Num() > 0)
+	{
+		AAEPhysicalActor::NotifyAttachmentChanged();
 	}
 }
 
@@ -405,7 +914,7 @@ FTransform UAEGameplayStatics::GetRelativeTransformBetweenComponents(USceneCompo
 	}
 	else
 	{
-		UE_LOG_ON_SCREEN(AE, Error, 5.f, FColor::Red,
+		AE_LOG_ON_SCREEN(AE, Error, 5.f, FColor::Red,
 			TEXT("GetRelativeTransformBetweenComponents passed Child \"%s\" and Parent \"%s\".  Both need to be not NULL."),
 			Child
 			? *Child->GetName()
@@ -549,6 +1058,15 @@ FVector UAEGameplayStatics::GetSafeActorSpawnLocation(UPrimitiveComponent * Spaw
 				true);
 		}
 	}
+
+	if (ResultLocation != SpawnedActorWorldLocation)
+	{
+		AE_RECORD_EVENT(SAFE_SPAWN_ADJUST, SpawningActorCollision->GetOwner() ? SpawningActorCollision->GetOwner()->GetFName() : NAME_None,
+			SpawningActorCollision->GetFName(),
+			NAME_None,
+			SpawnedActorWorldLocation,
+			ResultLocation);
+	}
 	
 	return ResultLocation;
 }
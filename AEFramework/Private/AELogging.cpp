@@ -1,3 +1,131 @@
 #include "AELogging.h"
 
-DEFINE_LOG_CATEGORY(AE);
\ No newline at end of file
+#include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
+#include "Engine/Engine.h"
+
+DEFINE_LOG_CATEGORY(AE);
+
+#if AE_LOGGING
+
+static float GAERepeatInterval = 1.f;
+
+static FAutoConsoleVariableRef CVarAELogRepeatInterval(
+	TEXT("ae.LogRepeatInterval"),
+	GAERepeatInterval,
+	TEXT("Seconds before the same AE_LOG_ON_SCREEN call site logs again.  Messages in between are counted and reported with the next one."));
+
+static FCriticalSection GAELogCriticalSection;
+
+bool FAELog::ShouldLog(FAELogCallSite& CallSite, int32& OutSuppressedCount)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	FScopeLock Lock(&GAELogCriticalSection);
+
+	if (Now - CallSite.LastLogTime < GAERepeatInterval)
+	{
+		++CallSite.SuppressedCount;
+		return false;
+	}
+
+	OutSuppressedCount = CallSite.SuppressedCount;
+	CallSite.SuppressedCount = 0;
+	CallSite.LastLogTime = Now;
+
+	return true;
+}
+
+#if AE_ON_SCREEN_LOGGING
+
+static int32 GAEMaxOnScreenMessagesPerFrame = 8;
+
+static FAutoConsoleVariableRef CVarAEMaxOnScreenMessagesPerFrame(
+	TEXT("ae.MaxOnScreenMessagesPerFrame"),
+	GAEMaxOnScreenMessagesPerFrame,
+	TEXT("Most AE_LOG_ON_SCREEN messages added to the screen per frame.  The rest wait for later frames."));
+
+struct FAEOnScreenMessage
+{
+	uint64 Key;
+
+	float TimeToDisplay;
+
+	FColor DisplayColor;
+
+	FString Message;
+};
+
+/**
+Messages waiting for the end of the frame, at most one per call site.
+*/
+static TArray<FAEOnScreenMessage> GAEPendingOnScreenMessages;
+
+static void FlushOnScreenMessages()
+{
+	TArray<FAEOnScreenMessage> Messages;
+
+	{
+		FScopeLock Lock(&GAELogCriticalSection);
+
+		const int32 NumToShow = FMath::Min(FMath::Max(GAEMaxOnScreenMessagesPerFrame, 1), GAEPendingOnScreenMessages.Num());
+
+		Messages.Append(GAEPendingOnScreenMessages.GetData(), NumToShow);
+		GAEPendingOnScreenMessages.RemoveAt(0, NumToShow, false);
+	}
+
+	if (GEngine && !IsRunningDedicatedServer())
+	{
+		for (const FAEOnScreenMessage& Message : Messages)
+		{
+			//keyed by call site so a repeating message replaces its line instead of filling the screen
+			GEngine->AddOnScreenDebugMessage(Message.Key, Message.TimeToDisplay, Message.DisplayColor, Message.Message);
+		}
+	}
+}
+
+static void QueueOnScreenMessage(uint64 Key, float TimeToDisplay, FColor DisplayColor, const FString& Message)
+{
+	static bool bRegisteredFlush = false;
+
+	FScopeLock Lock(&GAELogCriticalSection);
+
+	if (!bRegisteredFlush)
+	{
+		bRegisteredFlush = true;
+		FCoreDelegates::OnEndFrame.AddStatic(&FlushOnScreenMessages);
+	}
+
+	FAEOnScreenMessage * PendingMessage = GAEPendingOnScreenMessages.FindByPredicate([Key](const FAEOnScreenMessage& Pending)
+	{
+		return Pending.Key == Key;
+	});
+
+	if (!PendingMessage)
+	{
+		PendingMessage = &GAEPendingOnScreenMessages[GAEPendingOnScreenMessages.AddDefaulted()];
+		PendingMessage->Key = Key;
+	}
+
+	PendingMessage->TimeToDisplay = TimeToDisplay;
+	PendingMessage->DisplayColor = DisplayColor;
+	PendingMessage->Message = Message;
+}
+
+#endif // AE_ON_SCREEN_LOGGING
+
+void FAELog::Log(const FAELogCallSite& CallSite, const ANSICHAR * File, int32 Line, const FLogCategoryBase& Category, ELogVerbosity::Type Verbosity,
+	float TimeToDisplay, FColor DisplayColor, int32 SuppressedCount, const FString& Message)
+{
+	const FString FullMessage = SuppressedCount > 0
+		? FString::Printf(TEXT("%s (%d similar messages suppressed)"), *Message, SuppressedCount)
+		: Message;
+
+	FMsg::Logf(File, Line, Category.GetCategoryName(), Verbosity, TEXT("%s"), *FullMessage);
+
+#if AE_ON_SCREEN_LOGGING
+	QueueOnScreenMessage((uint64)(UPTRINT)&CallSite, TimeToDisplay, DisplayColor, FullMessage);
+#endif // AE_ON_SCREEN_LOGGING
+}
+
+#endif // AE_LOGGING
@@ -1,6 +1,8 @@
 #include "AEAnimNotify_Named.h"
 #include "Components/SkeletalMeshComponent.h"
 
+#include "AEEventLog.h"
+
 UAEAnimNotified_Named_Responder::UAEAnimNotified_Named_Responder(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {}
@@ -13,6 +15,10 @@ void UAEAnimNotify_Named::Notify(class USkeletalMeshComponent* MeshComp, class U
 	// Don't call super to avoid call back in to blueprints
 	UAnimInstance * AnimInstance = MeshComp->GetAnimInstance();
 
+	AE_RECORD_EVENT(NAMED_NOTIFY, MeshComp->GetOwner() ? MeshComp->GetOwner()->GetFName() : NAME_None,
+		NotificationName,
+		Animation ? Animation->GetFName() : NAME_None);
+
 	if (AnimInstance && AnimInstance->GetClass()->ImplementsInterface(UAEAnimNotified_Named_Responder::StaticClass()))
 	{
 		IAEAnimNotified_Named_Responder::Execute_OnNamedAnimNotify(AnimInstance, NotificationName, UserData);
@@ -0,0 +1,474 @@
+#include "AEEventLog.h"
+
+#include "HAL/PlatformTLS.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/FileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+
+#include "AELogging.h"
+
+#if AE_EVENT_LOG
+
+int32 FAEEventLog::bEnabled = 1;
+
+static FAutoConsoleVariableRef CVarAEEventLog(
+	TEXT("ae.EventLog"),
+	FAEEventLog::bEnabled,
+	TEXT("1 to record AE framework events to the per thread event log buffers.  See AE.FlushEventLog."));
+
+static FAutoConsoleCommand FlushEventLogCommand(
+	TEXT("AE.FlushEventLog"),
+	TEXT("Writes the AE event log to a file.  Takes an optional filename, defaults to Saved/Logs/AEEventLog-<timestamp>.aeev"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FAEEventLog::Flush(Args.Num() > 0 ? Args[0] : FAEEventLog::GetDefaultFilename());
+	}));
+
+/**
+Only the owning thread writes to a buffer.  WriteCount is published after the record is written so a flush never reads past it.
+*/
+struct FAEEventRingBuffer
+{
+	uint32 ThreadId;
+
+	volatile int64 WriteCount;
+
+	/**
+	WriteCount when the current flush counted the records, so the records it writes match the count in the header.
+	Only touched with GAEEventBuffersCriticalSection held.
+	*/
+	int64 FlushWriteCount;
+
+	FAEEventRecord Records[FAEEventLog::RECORDS_PER_THREAD];
+};
+
+/**
+Every buffer ever created.  Buffers aren't freed when their thread exits so their events still make it into the file.
+*/
+static TArray<FAEEventRingBuffer *> GAEEventBuffers;
+
+static FCriticalSection GAEEventBuffersCriticalSection;
+
+static uint32 GAEEventBufferTlsSlot = FPlatformTLS::AllocTlsSlot();
+
+/**
+Opened along with the first buffer so the crash handler doesn't have to allocate a file handle.
+*/
+static IFileHandle * GAEEventCrashFile = NULL;
+
+static FString GAEEventCrashFilename;
+
+/**
+Writes the header, every buffer's records in buffer order, then the plain string of each name the records use until the end of the file.
+Doesn't allocate so the crash handler can use it.  The caller holds GAEEventBuffersCriticalSection.
+
+@return the number of records written, or INDEX_NONE if writing failed
+*/
+static int32 WriteEventLog(IFileHandle& File)
+{
+	bool bSuccess = true;
+
+	auto Write = [&File, &bSuccess](const void * Data, int64 Size)
+	{
+		bSuccess = File.Write((const uint8 *)Data, Size) && bSuccess;
+	};
+
+	int32 NumRecords = 0;
+
+	for (FAEEventRingBuffer * Buffer : GAEEventBuffers)
+	{
+		Buffer->FlushWriteCount = Buffer->WriteCount;
+
+		FPlatformMisc::MemoryBarrier();
+
+		NumRecords += (int32)FMath::Min<int64>(Buffer->FlushWriteCount, FAEEventLog::RECORDS_PER_THREAD);
+	}
+
+	const uint32 Magic = FAEEventLog::FILE_MAGIC;
+	const uint32 Version = FAEEventLog::FILE_VERSION;
+	const double SecondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+
+	Write(&Magic, sizeof(Magic));
+	Write(&Version, sizeof(Version));
+	Write(&SecondsPerCycle, sizeof(SecondsPerCycle));
+	Write(&NumRecords, sizeof(NumRecords));
+
+	//the ring wraps at most once, so a buffer is at most two contiguous writes
+	for (const FAEEventRingBuffer * Buffer : GAEEventBuffers)
+	{
+		const int64 NumBufferRecords = FMath::Min<int64>(Buffer->FlushWriteCount, FAEEventLog::RECORDS_PER_THREAD);
+		const int64 FirstRecordInd = (Buffer->FlushWriteCount - NumBufferRecords) % FAEEventLog::RECORDS_PER_THREAD;
+		const int64 NumFirstRecords = FMath::Min<int64>(NumBufferRecords, FAEEventLog::RECORDS_PER_THREAD - FirstRecordInd);
+
+		Write(&Buffer->Records[FirstRecordInd], NumFirstRecords * sizeof(FAEEventRecord));
+		Write(&Buffer->Records[0], (NumBufferRecords - NumFirstRecords) * sizeof(FAEEventRecord));
+	}
+
+	//the decoder runs in another process so indices alone mean nothing to it.
+	//Direct mapped instead of a set so nothing is allocated, a name whose slot got reused is just written again.
+	int32 WrittenNameIndices[256];
+	FMemory::Memset(WrittenNameIndices, 0xff, sizeof(WrittenNameIndices));
+
+	const TNameEntryArray& NameEntries = FName::GetNames();
+
+	for (const FAEEventRingBuffer * Buffer : GAEEventBuffers)
+	{
+		const int64 NumBufferRecords = FMath::Min<int64>(Buffer->FlushWriteCount, FAEEventLog::RECORDS_PER_THREAD);
+
+		for (int64 RecordInd = Buffer->FlushWriteCount - NumBufferRecords; RecordInd < Buffer->FlushWriteCount; ++RecordInd)
+		{
+			for (const FAEEventName& Name : Buffer->Records[RecordInd % FAEEventLog::RECORDS_PER_THREAD].Names)
+			{
+				int32& WrittenNameIndex = WrittenNameIndices[(uint32)Name.Index % ARRAY_COUNT(WrittenNameIndices)];
+
+				//a record overwritten mid flush can hold an index that was never a name
+				if (WrittenNameIndex == Name.Index || !NameEntries.IsValidIndex(Name.Index))
+				{
+					continue;
+				}
+
+				WrittenNameIndex = Name.Index;
+
+				const FNameEntry * Entry = NameEntries[Name.Index];
+
+				//negative length for wide names, like FString serialization
+				if (Entry->IsWide())
+				{
+					const int32 Length = FCStringWide::Strlen(Entry->GetWideName());
+					const int32 SavedLength = -Length;
+
+					Write(&Name.Index, sizeof(Name.Index));
+					Write(&SavedLength, sizeof(SavedLength));
+					Write(Entry->GetWideName(), Length * sizeof(WIDECHAR));
+				}
+				else
+				{
+					const int32 Length = FCStringAnsi::Strlen(Entry->GetAnsiName());
+
+					Write(&Name.Index, sizeof(Name.Index));
+					Write(&Length, sizeof(Length));
+					Write(Entry->GetAnsiName(), Length * sizeof(ANSICHAR));
+				}
+			}
+		}
+	}
+
+	return bSuccess ? NumRecords : INDEX_NONE;
+}
+
+static void FlushEventLogOnCrash()
+{
+	static volatile int32 bFlushed = 0;
+
+	if (!GAEEventCrashFile || FPlatformAtomics::InterlockedExchange(&bFlushed, 1))
+	{
+		return;
+	}
+
+	//the crashing thread may be the one holding the lock, so give up instead of waiting on it forever
+	bool bLocked = false;
+
+	for (int32 Attempt = 0; Attempt < 100 && !bLocked; ++Attempt)
+	{
+		bLocked = GAEEventBuffersCriticalSection.TryLock();
+
+		if (!bLocked)
+		{
+			FPlatformProcess::SleepNoStats(0.001f);
+		}
+	}
+
+	if (!bLocked)
+	{
+		return;
+	}
+
+	WriteEventLog(*GAEEventCrashFile);
+
+	GAEEventBuffersCriticalSection.Unlock();
+}
+
+static void DeleteEventLogCrashFileOnExit()
+{
+	FScopeLock Lock(&GAEEventBuffersCriticalSection);
+
+	if (GAEEventCrashFile)
+	{
+		delete GAEEventCrashFile;
+		GAEEventCrashFile = NULL;
+
+		IFileManager::Get().Delete(*GAEEventCrashFilename);
+	}
+}
+
+/**
+Deletes crash files left empty by earlier runs that were killed or crashed without the handler running.
+Files of processes that are still running, like other PIE instances, are left alone.
+*/
+static void DeleteStaleEventLogCrashFiles()
+{
+	const FString LogDir = FPaths::ProjectLogDir();
+
+	TArray<FString> CrashFiles;
+	IFileManager::Get().FindFiles(CrashFiles, *(LogDir / TEXT("AEEventLog-Crash-*.aeev")), true, false);
+
+	for (const FString& CrashFile : CrashFiles)
+	{
+		const FString CrashFilePath = LogDir / CrashFile;
+
+		//AEEventLog-Crash-<pid>-<timestamp>.aeev
+		FString ProcessIdString;
+		FString Rest;
+
+		if (!CrashFile.RightChop(FCString::Strlen(TEXT("AEEventLog-Crash-"))).Split(TEXT("-"), &ProcessIdString, &Rest) || !ProcessIdString.IsNumeric())
+		{
+			continue;
+		}
+
+		if (IFileManager::Get().FileSize(*CrashFilePath) == 0 && !FPlatformProcess::IsApplicationRunning((uint32)FCString::Atoi(*ProcessIdString)))
+		{
+			IFileManager::Get().Delete(*CrashFilePath);
+		}
+	}
+}
+
+static FAEEventRingBuffer * CreateThreadEventBuffer()
+{
+	FAEEventRingBuffer * Buffer = new FAEEventRingBuffer();
+	Buffer->ThreadId = FPlatformTLS::GetCurrentThreadId();
+	Buffer->WriteCount = 0;
+	Buffer->FlushWriteCount = 0;
+
+	FPlatformTLS::SetTlsValue(GAEEventBufferTlsSlot, Buffer);
+
+	FScopeLock Lock(&GAEEventBuffersCriticalSection);
+
+	if (GAEEventBuffers.Num() == 0)
+	{
+		DeleteStaleEventLogCrashFiles();
+
+		GAEEventCrashFilename = FPaths::ProjectLogDir() / FString::Printf(TEXT("AEEventLog-Crash-%u-%s.aeev"), FPlatformProcess::GetCurrentProcessId(), *FDateTime::Now().ToString());
+		GAEEventCrashFile = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*GAEEventCrashFilename);
+
+		if (GAEEventCrashFile)
+		{
+			FCoreDelegates::OnHandleSystemError.AddStatic(&FlushEventLogOnCrash);
+			FCoreDelegates::OnExit.AddStatic(&DeleteEventLogCrashFileOnExit);
+		}
+		else
+		{
+			UE_LOG(AE, Warning, TEXT("FAEEventLog couldn't open \"%s\", the event log won't be written on a crash"), *GAEEventCrashFilename);
+		}
+	}
+
+	GAEEventBuffers.Add(Buffer);
+
+	return Buffer;
+}
+
+void FAEEventLog::Record(AEEventType::Type Type, FName Name0, FName Name1, FName Name2, const FVector& Value0, const FVector& Value1)
+{
+	FAEEventRingBuffer * Buffer = (FAEEventRingBuffer *)FPlatformTLS::GetTlsValue(GAEEventBufferTlsSlot);
+
+	if (!Buffer)
+	{
+		Buffer = CreateThreadEventBuffer();
+	}
+
+	const int64 WriteCount = Buffer->WriteCount;
+
+	FAEEventRecord& Record = Buffer->Records[WriteCount % RECORDS_PER_THREAD];
+	Record.Cycles = FPlatformTime::Cycles64();
+	Record.ThreadId = Buffer->ThreadId;
+	Record.Type = (uint8)Type;
+	Record.Names[0] = FAEEventName::Make(Name0);
+	Record.Names[1] = FAEEventName::Make(Name1);
+	Record.Names[2] = FAEEventName::Make(Name2);
+	Record.Values[0] = Value0.X;
+	Record.Values[1] = Value0.Y;
+	Record.Values[2] = Value0.Z;
+	Record.Values[3] = Value1.X;
+	Record.Values[4] = Value1.Y;
+	Record.Values[5] = Value1.Z;
+
+	FPlatformMisc::MemoryBarrier();
+
+	Buffer->WriteCount = WriteCount + 1;
+}
+
+bool FAEEventLog::Flush(const FString& Filename)
+{
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Filename));
+
+	if (!File)
+	{
+		UE_LOG(AE, Error, TEXT("FAEEventLog couldn't open \"%s\" for writing"), *Filename);
+		return false;
+	}
+
+	int32 NumRecords = INDEX_NONE;
+
+	{
+		FScopeLock Lock(&GAEEventBuffersCriticalSection);
+
+		NumRecords = WriteEventLog(*File);
+	}
+
+	if (NumRecords == INDEX_NONE)
+	{
+		UE_LOG(AE, Error, TEXT("FAEEventLog couldn't write to \"%s\""), *Filename);
+		return false;
+	}
+
+	UE_LOG(AE, Log, TEXT("FAEEventLog wrote %d events to \"%s\""), NumRecords, *Filename);
+
+	return true;
+}
+
+FString FAEEventLog::GetDefaultFilename()
+{
+	return FPaths::ProjectLogDir() / FString::Printf(TEXT("AEEventLog-%s.aeev"), *FDateTime::Now().ToString());
+}
+
+#endif // AE_EVENT_LOG
+
+/**
+Quotes a CSV field if it has a comma, quote or line break in it, doubling any quotes.
+*/
+static FString EscapeCsvField(const FString& Field)
+{
+	if (!Field.Contains(TEXT(",")) && !Field.Contains(TEXT("\"")) && !Field.Contains(TEXT("\n")) && !Field.Contains(TEXT("\r")))
+	{
+		return Field;
+	}
+
+	return TEXT("\"") + Field.Replace(TEXT("\""), TEXT("\"\"")) + TEXT("\"");
+}
+
+bool FAEEventLog::DecodeToCsv(const TArray<uint8>& FileData, FString& OutCsv)
+{
+	FMemoryReader Ar(FileData);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	double SecondsPerCycle = 0.0;
+
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsError() || Magic != FILE_MAGIC || Version != FILE_VERSION)
+	{
+		return false;
+	}
+
+	Ar << SecondsPerCycle;
+
+	int32 NumRecords = 0;
+
+	Ar << NumRecords;
+
+	if (Ar.IsError() || NumRecords < 0 || Ar.TotalSize() - Ar.Tell() < (int64)NumRecords * (int64)sizeof(FAEEventRecord))
+	{
+		return false;
+	}
+
+	TArray<FAEEventRecord> Records;
+	Records.SetNumUninitialized(NumRecords);
+	Ar.Serialize(Records.GetData(), NumRecords * sizeof(FAEEventRecord));
+
+	//the rest of the file is names, the same name can be there more than once
+	TMap<int32, FString> Names;
+
+	while (!Ar.AtEnd())
+	{
+		int32 Index = 0;
+		int32 Length = 0;
+
+		Ar << Index;
+		Ar << Length;
+
+		const bool bWide = Length < 0;
+		const int64 NumBytes = (int64)FMath::Abs(Length) * (bWide ? sizeof(WIDECHAR) : sizeof(ANSICHAR));
+
+		if (Ar.IsError() || Ar.TotalSize() - Ar.Tell() < NumBytes)
+		{
+			return false;
+		}
+
+		if (bWide)
+		{
+			TArray<WIDECHAR> Chars;
+			Chars.SetNumZeroed(-Length + 1);
+			Ar.Serialize(Chars.GetData(), NumBytes);
+
+			Names.Add(Index, FString(Chars.GetData()));
+		}
+		else
+		{
+			TArray<ANSICHAR> Chars;
+			Chars.SetNumZeroed(Length + 1);
+			Ar.Serialize(Chars.GetData(), NumBytes);
+
+			Names.Add(Index, FString(Chars.GetData()));
+		}
+	}
+
+	Records.Sort([](const FAEEventRecord& A, const FAEEventRecord& B)
+	{
+		return A.Cycles < B.Cycles;
+	});
+
+	OutCsv = TEXT("Seconds,ThreadId,Event,Name0,Name1,Name2,Value0,Value1,Value2,Value3,Value4,Value5\n");
+
+	const uint64 BaseCycles = Records.Num() > 0 ? Records[0].Cycles : 0;
+
+	for (const FAEEventRecord& Record : Records)
+	{
+		OutCsv += FString::Printf(TEXT("%.6f,%u,%s"), (Record.Cycles - BaseCycles) * SecondsPerCycle, Record.ThreadId, GetEventTypeName(Record.Type));
+
+		for (const FAEEventName& Name : Record.Names)
+		{
+			const FString * NameString = Names.Find(Name.Index);
+
+			OutCsv += TEXT(",");
+
+			if (NameString && Name.Number != NAME_NO_NUMBER_INTERNAL)
+			{
+				OutCsv += EscapeCsvField(FString::Printf(TEXT("%s_%d"), **NameString, NAME_INTERNAL_TO_EXTERNAL(Name.Number)));
+			}
+			else if (NameString)
+			{
+				OutCsv += EscapeCsvField(*NameString);
+			}
+		}
+
+		for (const float Value : Record.Values)
+		{
+			OutCsv += FString::Printf(TEXT(",%f"), Value);
+		}
+
+		OutCsv += TEXT("\n");
+	}
+
+	return true;
+}
+
+const TCHAR * FAEEventLog::GetEventTypeName(uint8 Type)
+{
+	static const TCHAR * EventTypeNames[AEEventType::MAX] =
+	{
+		TEXT("StateTransition"),
+		TEXT("NamedNotify"),
+		TEXT("AttachmentSpawn"),
+		TEXT("AttachmentDisconnect"),
+		TEXT("SafeSpawnAdjust"),
+	};
+
+	return Type < AEEventType::MAX ? EventTypeNames[Type] : TEXT("Unknown");
+}
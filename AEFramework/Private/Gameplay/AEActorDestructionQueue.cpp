@@ -0,0 +1,197 @@
+#include "AEActorDestructionQueue.h"
+
+#include "AEGameplayStatics.h"
+#include "AEActorStateBatcher.h"
+#include "AEPhysicalActor.h"
+#include "AEActorPool.h"
+
+DECLARE_STATS_GROUP(TEXT("AEFramework"), STATGROUP_AEFramework, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Destruction Queue Tick"), STAT_AEDestructionQueueTick, STATGROUP_AEFramework);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Destruction Queue Depth"), STAT_AEDestructionQueueDepth, STATGROUP_AEFramework);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Actors Destroyed From Queue"), STAT_AEDestructionQueueDestroyed, STATGROUP_AEFramework);
+
+static float GAEDestructionQueueBudgetMs = 1.f;
+
+static FAutoConsoleVariableRef CVarAEDestructionQueueBudgetMs(
+	TEXT("ae.DestructionQueueBudgetMs"),
+	GAEDestructionQueueBudgetMs,
+	TEXT("Milliseconds per frame AAEActorDestructionQueue spends destroying queued actors."));
+
+TArray<AAEActorDestructionQueue *> AAEActorDestructionQueue::Instances;
+
+AAEActorDestructionQueue::AAEActorDestructionQueue(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	bReplicates = false;
+	bHidden = true;
+}
+
+void AAEActorDestructionQueue::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	Instances.Add(this);
+}
+
+void AAEActorDestructionQueue::BeginDestroy()
+{
+	//destroyed without ever getting EndPlay
+	Instances.RemoveSwap(this);
+
+	Super::BeginDestroy();
+}
+
+void AAEActorDestructionQueue::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Instances.RemoveSwap(this);
+
+	Queue.Empty();
+	QueueHead = 0;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AAEActorDestructionQueue * AAEActorDestructionQueue::Get(UWorld * World)
+{
+	if (!World)
+	{
+		return NULL;
+	}
+
+	for (AAEActorDestructionQueue * Instance : Instances)
+	{
+		if (Instance->GetWorld() == World && !Instance->IsPendingKill())
+		{
+			return Instance;
+		}
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<AAEActorDestructionQueue>(SpawnParams);
+}
+
+void AAEActorDestructionQueue::Enqueue(AActor * RootActor, bool bIncludeRootActor)
+{
+	if (!RootActor)
+	{
+		return;
+	}
+
+	//pooled actors skip the queue, releasing them is cheap and they keep their attached actors
+	if (bIncludeRootActor && AAEActorPool::ReleaseActor(Cast<AAEPhysicalActor>(RootActor)))
+	{
+		return;
+	}
+
+	TArray<FAEQueuedDestruction, TInlineAllocator<AE_COMPONENT_TRAVERSAL_INLINE_SIZE>> Heirarchy;
+
+	if (bIncludeRootActor)
+	{
+		Heirarchy.Add({ RootActor, 0 });
+	}
+
+	//attached actors are visited after the actor they're attached to, so the parent's depth is always known
+	TMap<AActor *, int32, TInlineSetAllocator<AE_COMPONENT_TRAVERSAL_INLINE_SIZE>> Depths;
+	Depths.Add(RootActor, 0);
+
+	AttachedActorsHelper(RootActor, RootActor->GetRootComponent(), [&Heirarchy, &Depths](AActor * Actor)
+	{
+		if (AAEActorPool::ReleaseActor(Cast<AAEPhysicalActor>(Actor)))
+		{
+			return false;
+		}
+
+		const int32 * ParentDepth = Depths.Find(Actor->GetAttachParentActor());
+		const int32 Depth = ParentDepth ? *ParentDepth + 1 : 1;
+
+		Depths.Add(Actor, Depth);
+		Heirarchy.Add({ Actor, Depth });
+
+		return true;
+	});
+
+	//hide the whole heirarchy now so it looks gone while it's being destroyed
+	for (const FAEQueuedDestruction& Queued : Heirarchy)
+	{
+		AAEActorStateBatcher::RequestActorHiddenInGame(Queued.Actor.Get(), true);
+		AAEActorStateBatcher::RequestActorEnableCollision(Queued.Actor.Get(), false);
+	}
+
+	AAEActorStateBatcher * StateBatcher = AAEActorStateBatcher::Get(GetWorld());
+
+	if (StateBatcher)
+	{
+		StateBatcher->Flush();
+	}
+
+	Heirarchy.StableSort([](const FAEQueuedDestruction& A, const FAEQueuedDestruction& B)
+	{
+		return A.Depth > B.Depth;
+	});
+
+	Queue.Append(Heirarchy);
+}
+
+void AAEActorDestructionQueue::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AEDestructionQueueTick);
+
+	Super::Tick(DeltaTime);
+
+	const double EndTime = FPlatformTime::Seconds() + GAEDestructionQueueBudgetMs * 0.001;
+	int32 NumDestroyed = 0;
+
+	while (QueueHead < Queue.Num())
+	{
+		const FAEQueuedDestruction& Queued = Queue[QueueHead++];
+		AActor * Actor = Queued.Actor.Get();
+
+		if (Actor && !Actor->IsPendingKill())
+		{
+			//the root goes last, through DestroyActorHeirarchy so overrides still get to clean up
+			AAEPhysicalActor * PhysicalRoot = Queued.Depth == 0 ? Cast<AAEPhysicalActor>(Actor) : NULL;
+
+			if (PhysicalRoot)
+			{
+				PhysicalRoot->DestroyActorHeirarchy();
+			}
+			else
+			{
+				Actor->Destroy();
+			}
+
+			++NumDestroyed;
+
+			if (FPlatformTime::Seconds() >= EndTime)
+			{
+				break;
+			}
+		}
+	}
+
+	if (QueueHead == Queue.Num())
+	{
+		Queue.Reset();
+		QueueHead = 0;
+	}
+	else if (QueueHead > Queue.Num() / 2)
+	{
+		Queue.RemoveAt(0, QueueHead, false);
+		QueueHead = 0;
+	}
+
+	if (NumDestroyed > 0)
+	{
+		AAEPhysicalActor::NotifyAttachmentChanged();
+	}
+
+	SET_DWORD_STAT(STAT_AEDestructionQueueDepth, GetQueueDepth());
+	INC_DWORD_STAT_BY(STAT_AEDestructionQueueDestroyed, NumDestroyed);
+}
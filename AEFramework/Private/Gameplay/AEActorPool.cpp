@@ -0,0 +1,349 @@
+#include "AEActorPool.h"
+
+#include "UObject/UObjectHash.h"
+
+#include "AEGameplayStatics.h"
+#include "AEPhysicalActor.h"
+#include "AEPhysicalActorAttachmentComponent.h"
+#include "AEResetInterface.h"
+#include "AEActorStateBatcher.h"
+#include "AEStateManager.h"
+
+static int32 GAEActorPoolMaxPerClass = 32;
+
+static FAutoConsoleVariableRef CVarAEActorPoolMaxPerClass(
+	TEXT("ae.ActorPoolMaxPerClass"),
+	GAEActorPoolMaxPerClass,
+	TEXT("Most released actors AAEActorPool keeps per class, extra released actors are destroyed."));
+
+TArray<AAEActorPool *> AAEActorPool::Instances;
+
+/**
+Pauses ticks and clears the timers and latent actions of the actor, the actors attached to it, their components and their state managers,
+so nothing in the heirarchy runs while it's in the pool.  Only ticks are restored when it's acquired.
+*/
+static void PauseHeirarchy(AAEPhysicalActor * Actor, FAEPooledActorTickState& OutTickState)
+{
+	FTimerManager& TimerManager = Actor->GetWorldTimerManager();
+	FLatentActionManager& LatentActionManager = Actor->GetWorld()->GetLatentActionManager();
+
+	TArray<AActor *, TInlineAllocator<AE_COMPONENT_TRAVERSAL_INLINE_SIZE>> HeirarchyActors;
+	HeirarchyActors.Add(Actor);
+
+	AttachedActorsHelper(Actor, Actor->GetRootComponent(), [&HeirarchyActors](AActor * AttachedActor)
+	{
+		HeirarchyActors.Add(AttachedActor);
+		return true;
+	});
+
+	TArray<UObject *> Subobjects;
+
+	for (AActor * HeirarchyActor : HeirarchyActors)
+	{
+		if (HeirarchyActor->IsActorTickEnabled())
+		{
+			HeirarchyActor->SetActorTickEnabled(false);
+			OutTickState.Actors.Add(HeirarchyActor);
+		}
+
+		TimerManager.ClearAllTimersForObject(HeirarchyActor);
+		LatentActionManager.RemoveActionsForObject(HeirarchyActor);
+
+		TInlineComponentArray<UActorComponent *> Components(HeirarchyActor);
+
+		for (UActorComponent * Component : Components)
+		{
+			TimerManager.ClearAllTimersForObject(Component);
+			LatentActionManager.RemoveActionsForObject(Component);
+
+			if (Component->IsComponentTickEnabled())
+			{
+				Component->SetComponentTickEnabled(false);
+				OutTickState.Components.Add(Component);
+			}
+		}
+
+		//state managers are subobjects of the actor, not components
+		Subobjects.Reset();
+		GetObjectsWithOuter(HeirarchyActor, Subobjects, false);
+
+		for (UObject * Subobject : Subobjects)
+		{
+			UAEStateManager * StateManager = Cast<UAEStateManager>(Subobject);
+
+			if (!StateManager)
+			{
+				continue;
+			}
+
+			StateManager->ClearTimersAndLatentActions();
+
+			if (StateManager->IsRegisteredWithTickManager())
+			{
+				StateManager->UnregisterFromTickManager();
+				OutTickState.StateManagers.Add(StateManager);
+			}
+		}
+	}
+}
+
+static void ResumeHeirarchyTicks(const FAEPooledActorTickState& TickState)
+{
+	for (const TWeakObjectPtr<AActor>& Actor : TickState.Actors)
+	{
+		if (Actor.IsValid())
+		{
+			Actor->SetActorTickEnabled(true);
+		}
+	}
+
+	for (const TWeakObjectPtr<UActorComponent>& Component : TickState.Components)
+	{
+		if (Component.IsValid())
+		{
+			Component->SetComponentTickEnabled(true);
+		}
+	}
+
+	for (const TWeakObjectPtr<UAEStateManager>& StateManager : TickState.StateManagers)
+	{
+		if (StateManager.IsValid())
+		{
+			StateManager->RegisterWithTickManager();
+		}
+	}
+}
+
+AAEActorPool::AAEActorPool(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	bReplicates = false;
+	bHidden = true;
+}
+
+void AAEActorPool::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	Instances.Add(this);
+}
+
+void AAEActorPool::BeginDestroy()
+{
+	//destroyed without ever getting EndPlay
+	Instances.RemoveSwap(this);
+
+	Super::BeginDestroy();
+}
+
+void AAEActorPool::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Instances.RemoveSwap(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AAEActorPool * AAEActorPool::Get(UWorld * World)
+{
+	if (!World || !World->IsGameWorld() || World->bIsTearingDown)
+	{
+		return NULL;
+	}
+
+	for (AAEActorPool * Instance : Instances)
+	{
+		if (Instance->GetWorld() == World && !Instance->IsPendingKill())
+		{
+			return Instance;
+		}
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<AAEActorPool>(SpawnParams);
+}
+
+AAEPhysicalActor * AAEActorPool::SpawnOrAcquireActor(UWorld * World, TSubclassOf<AAEPhysicalActor> Class, const FTransform& Transform, AActor * Owner)
+{
+	if (!World || !Class)
+	{
+		return NULL;
+	}
+
+	AAEActorPool * Pool = Class->GetDefaultObject<AAEPhysicalActor>()->bUseActorPool ? Get(World) : NULL;
+
+	if (Pool)
+	{
+		return Pool->AcquireActor(Class, Transform, Owner);
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = Owner;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	return World->SpawnActor<AAEPhysicalActor>(Class, Transform, SpawnParams);
+}
+
+bool AAEActorPool::ReleaseActor(AAEPhysicalActor * Actor)
+{
+	if (!Actor || !Actor->bUseActorPool || Actor->IsPendingKill())
+	{
+		return false;
+	}
+
+	AAEActorPool * Pool = Get(Actor->GetWorld());
+
+	if (!Pool)
+	{
+		return false;
+	}
+
+	Pool->Release(Actor);
+	return true;
+}
+
+AAEPhysicalActor * AAEActorPool::AcquireActor(TSubclassOf<AAEPhysicalActor> Class, const FTransform& Transform, AActor * Owner)
+{
+	if (!Class)
+	{
+		return NULL;
+	}
+
+	FAEActorPoolBucket * Bucket = Buckets.Find(Class);
+
+	while (Bucket && Bucket->Actors.Num() > 0)
+	{
+		AAEPhysicalActor * Actor = Bucket->Actors.Pop(false);
+		const FAEPooledActorTickState TickState = Bucket->TickStates.Pop(false);
+
+		//destroyed by something else while pooled
+		if (!Actor || Actor->IsPendingKill())
+		{
+			continue;
+		}
+
+		Actor->bIsInActorPool = false;
+
+		Actor->SetActorTransform(Transform, false, NULL, ETeleportType::TeleportPhysics);
+		Actor->SetOwner(Owner);
+
+		ResumeHeirarchyTicks(TickState);
+
+		Actor->SetActorHeirarchyHiddenInGame(false);
+		Actor->SetActorHeirarchyEnableCollision(true);
+
+		if (Actor->GetClass()->ImplementsInterface(UAEResetInterface::StaticClass()))
+		{
+			IAEResetInterface::Execute_Reset(Actor);
+		}
+
+		//reattaches the attachments and gives them their default visibility and collision
+		Actor->OnAcquiredFromPool();
+
+		//hidden and collision changes go through the batcher, they have to land before the actor starts simulating
+		AAEActorStateBatcher * StateBatcher = AAEActorStateBatcher::Get(GetWorld());
+
+		if (StateBatcher)
+		{
+			StateBatcher->Flush();
+		}
+
+		//only the actor's own bodies, like a freshly spawned actor, attachments were set up by OnAcquiredFromPool
+		Actor->SetPhysicsEnabled(true);
+
+		return Actor;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = Owner;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	return GetWorld()->SpawnActor<AAEPhysicalActor>(Class, Transform, SpawnParams);
+}
+
+void AAEActorPool::Release(AAEPhysicalActor * Actor)
+{
+	if (!Actor || Actor->bIsInActorPool || Actor->IsPendingKill())
+	{
+		return;
+	}
+
+	FAEActorPoolBucket& Bucket = Buckets.FindOrAdd(Actor->GetClass());
+
+	if (Bucket.Actors.Num() >= GAEActorPoolMaxPerClass)
+	{
+		//not DestroyActorHeirarchy, that would release it right back here
+		UAEGameplayStatics::DestroyAttachedActors(Actor);
+		Actor->Destroy();
+
+		AAEPhysicalActor::NotifyAttachmentChanged();
+		return;
+	}
+
+	Actor->OnReleasedToPool();
+
+	//don't leave an attachment component pointing at an actor that's about to be handed out somewhere else
+	if (AActor * ParentActor = Actor->GetAttachParentActor())
+	{
+		TInlineComponentArray<UAEPhysicalActorAttachmentComponent *> AttachmentComponents(ParentActor);
+
+		for (UAEPhysicalActorAttachmentComponent * AttachmentComponent : AttachmentComponents)
+		{
+			if (AttachmentComponent->AttachedActor == Actor)
+			{
+				AttachmentComponent->AttachedActor = NULL;
+			}
+		}
+	}
+
+	Actor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+
+	Actor->SetActorHeirarchyPhysicsEnabled(false);
+	Actor->SetActorHeirarchyEnableCollision(false);
+	Actor->SetActorHeirarchyHiddenInGame(true);
+
+	Actor->SetOwner(NULL);
+
+	Actor->bIsInActorPool = true;
+	Bucket.Actors.Add(Actor);
+
+	PauseHeirarchy(Actor, Bucket.TickStates[Bucket.TickStates.AddDefaulted()]);
+
+	AAEPhysicalActor::NotifyAttachmentChanged();
+}
+
+void AAEActorPool::Prewarm(TSubclassOf<AAEPhysicalActor> Class, int32 Count)
+{
+	if (!Class)
+	{
+		return;
+	}
+
+	Count = FMath::Min(Count, GAEActorPoolMaxPerClass);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (int32 NumPooled = GetNumPooledActors(Class); NumPooled < Count; ++NumPooled)
+	{
+		AAEPhysicalActor * Actor = GetWorld()->SpawnActor<AAEPhysicalActor>(Class, GetActorTransform(), SpawnParams);
+
+		if (!Actor)
+		{
+			break;
+		}
+
+		Release(Actor);
+	}
+}
+
+int32 AAEActorPool::GetNumPooledActors(TSubclassOf<AAEPhysicalActor> Class) const
+{
+	const FAEActorPoolBucket * Bucket = Buckets.Find(Class);
+
+	return Bucket ? Bucket->Actors.Num() : 0;
+}
@@ -0,0 +1,160 @@
+#include "AEActorStateBatcher.h"
+
+static int32 GAEDeferHeirarchyStateUpdates = 1;
+
+static FAutoConsoleVariableRef CVarAEDeferHeirarchyStateUpdates(
+	TEXT("ae.DeferHeirarchyStateUpdates"),
+	GAEDeferHeirarchyStateUpdates,
+	TEXT("1 to apply heirarchy hidden and collision changes once at the end of the frame, 0 to apply them immediately."));
+
+TArray<AAEActorStateBatcher *> AAEActorStateBatcher::Instances;
+
+AAEActorStateBatcher::AAEActorStateBatcher(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.bTickEvenWhenPaused = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	bReplicates = false;
+	bHidden = true;
+}
+
+void AAEActorStateBatcher::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	Instances.Add(this);
+}
+
+void AAEActorStateBatcher::BeginDestroy()
+{
+	//destroyed without ever getting EndPlay
+	Instances.RemoveSwap(this);
+
+	Super::BeginDestroy();
+}
+
+void AAEActorStateBatcher::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Flush();
+
+	Instances.RemoveSwap(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AAEActorStateBatcher * AAEActorStateBatcher::Get(UWorld * World)
+{
+	if (!World || !World->IsGameWorld() || World->bIsTearingDown)
+	{
+		return NULL;
+	}
+
+	for (AAEActorStateBatcher * Instance : Instances)
+	{
+		if (Instance->GetWorld() == World && !Instance->IsPendingKill())
+		{
+			return Instance;
+		}
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<AAEActorStateBatcher>(SpawnParams);
+}
+
+void AAEActorStateBatcher::RequestActorHiddenInGame(AActor * Actor, bool bNewHidden)
+{
+	AAEActorStateBatcher * Batcher = GAEDeferHeirarchyStateUpdates ? Get(Actor->GetWorld()) : NULL;
+
+	if (Batcher)
+	{
+		const int32 * PendingInd = Batcher->PendingStateIndices.Find(Actor);
+
+		//nothing pending and nothing to change
+		if (!PendingInd && !!Actor->bHidden == bNewHidden)
+		{
+			return;
+		}
+
+		FAEPendingActorState& PendingState = PendingInd ? Batcher->PendingStates[*PendingInd] : Batcher->AddPendingState(Actor);
+		PendingState.bHasHidden = true;
+		PendingState.bHidden = bNewHidden;
+	}
+	else if (!!Actor->bHidden != bNewHidden)
+	{
+		Actor->SetActorHiddenInGame(bNewHidden);
+	}
+}
+
+void AAEActorStateBatcher::RequestActorEnableCollision(AActor * Actor, bool bNewCollision)
+{
+	AAEActorStateBatcher * Batcher = GAEDeferHeirarchyStateUpdates ? Get(Actor->GetWorld()) : NULL;
+
+	if (Batcher)
+	{
+		const int32 * PendingInd = Batcher->PendingStateIndices.Find(Actor);
+
+		if (!PendingInd && Actor->GetActorEnableCollision() == bNewCollision)
+		{
+			return;
+		}
+
+		FAEPendingActorState& PendingState = PendingInd ? Batcher->PendingStates[*PendingInd] : Batcher->AddPendingState(Actor);
+		PendingState.bHasCollision = true;
+		PendingState.bCollisionEnabled = bNewCollision;
+	}
+	else if (Actor->GetActorEnableCollision() != bNewCollision)
+	{
+		Actor->SetActorEnableCollision(bNewCollision);
+	}
+}
+
+FAEPendingActorState& AAEActorStateBatcher::AddPendingState(AActor * Actor)
+{
+	const int32 PendingInd = PendingStates.AddZeroed();
+	PendingStates[PendingInd].Actor = Actor;
+
+	PendingStateIndices.Add(Actor, PendingInd);
+
+	return PendingStates[PendingInd];
+}
+
+void AAEActorStateBatcher::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	Flush();
+}
+
+void AAEActorStateBatcher::Flush()
+{
+	//swapped out so requests made while applying, from overridden SetActorHiddenInGame for example, wait for the next flush
+	TArray<FAEPendingActorState> StatesToApply = MoveTemp(PendingStates);
+	PendingStates.Reset();
+	PendingStateIndices.Reset();
+
+	for (const FAEPendingActorState& PendingState : StatesToApply)
+	{
+		AActor * Actor = PendingState.Actor.Get();
+
+		if (!Actor || Actor->IsPendingKill())
+		{
+			continue;
+		}
+
+		if (PendingState.bHasHidden && !!Actor->bHidden != !!PendingState.bHidden)
+		{
+			Actor->SetActorHiddenInGame(PendingState.bHidden);
+		}
+
+		if (PendingState.bHasCollision && Actor->GetActorEnableCollision() != !!PendingState.bCollisionEnabled)
+		{
+			Actor->SetActorEnableCollision(PendingState.bCollisionEnabled);
+		}
+	}
+}
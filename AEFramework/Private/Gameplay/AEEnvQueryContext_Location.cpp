@@ -20,7 +20,7 @@ void UAEEnvQueryContext_Location::ProvideContext(FEnvQueryInstance& QueryInstanc
 
 	if (!X)
 	{
-		UE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEEnvQueryContext_Location named \"%s\" didn't find parameter \"%s\" in the query instance"), *GetName(), *PositionQueryXParameterName.ToString());
+		AE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEEnvQueryContext_Location named \"%s\" didn't find parameter \"%s\" in the query instance"), *GetName(), *PositionQueryXParameterName.ToString());
 		UEnvQueryItemType_Point::SetContextHelper(ContextData, FVector(0.f));
 		return;
 	}
@@ -29,7 +29,7 @@ void UAEEnvQueryContext_Location::ProvideContext(FEnvQueryInstance& QueryInstanc
 
 	if (!Y)
 	{
-		UE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEEnvQueryContext_Location named \"%s\" didn't find parameter \"%s\" in the query instance"), *GetName(), *PositionQueryYParameterName.ToString());
+		AE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEEnvQueryContext_Location named \"%s\" didn't find parameter \"%s\" in the query instance"), *GetName(), *PositionQueryYParameterName.ToString());
 		UEnvQueryItemType_Point::SetContextHelper(ContextData, FVector(0.f));
 		return;
 	}
@@ -38,7 +38,7 @@ void UAEEnvQueryContext_Location::ProvideContext(FEnvQueryInstance& QueryInstanc
 
 	if (!Z)
 	{
-		UE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEEnvQueryContext_Location named \"%s\" didn't find parameter \"%s\" in the query instance"), *GetName(), *PositionQueryZParameterName.ToString());
+		AE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEEnvQueryContext_Location named \"%s\" didn't find parameter \"%s\" in the query instance"), *GetName(), *PositionQueryZParameterName.ToString());
 		UEnvQueryItemType_Point::SetContextHelper(ContextData, FVector(0.f));
 		return;
 	}
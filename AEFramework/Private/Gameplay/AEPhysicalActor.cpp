@@ -1,21 +1,186 @@
 #include "AEPhysicalActor.h"
 
 #include "AEGameplayStatics.h"
+#include "AEActorStateBatcher.h"
+#include "AEActorDestructionQueue.h"
+#include "AEActorPool.h"
+#include "AEPhysicalActorAttachmentComponent.h"
+#include "AEStateManager.h"
+
+uint32 AAEPhysicalActor::AttachmentGeneration = 1;
+
+/**
+What LevelOrderComponentTraverse found for the first actor of a class, by component name.
+*/
+struct FAEComponentLayout
+{
+	/**
+	False if the layout can't be reused, LevelOrderComponentTraverse is overridden in Blueprint or found components of other actors.
+	*/
+	bool bCanUseLayout;
+
+	TArray<FName> PhysicsComponentNames;
+
+	FName SkeletalMeshName;
+
+	/**
+	Number of components the first actor owned.  Actors whose construction script added or removed components take the slow path.
+	*/
+	int32 NumComponents;
+};
+
+/**
+Game thread only, keyed by actor class.
+*/
+static TMap<TWeakObjectPtr<UClass>, FAEComponentLayout> GAEComponentLayouts;
 
 AAEPhysicalActor::AAEPhysicalActor(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
+	bCacheComponentLayout = false;
+	bUseActorPool = false;
+	bIsInActorPool = false;
 }
 
 void AAEPhysicalActor::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
-	LevelComponentsTraverser(GetRootComponent(), [this](USceneComponent * Component) -> bool
+	if (GetIsReplicated())
+	{
+		TArray<UObject *> Subobjects;
+		GetObjectsWithOuter(this, Subobjects, false);
+
+		for (UObject * Subobject : Subobjects)
+		{
+			UAEStateManager * StateManager = Cast<UAEStateManager>(Subobject);
+
+			if (StateManager && StateManager->bReplicateStates)
+			{
+				ReplicatedStateManagers.Add(StateManager);
+			}
+		}
+	}
+
+	if (bCacheComponentLayout && ApplyCachedComponentLayout())
+	{
+		return;
+	}
+
+	TraverseComponents<AEComponentTraversalOrder::BREADTH_FIRST>(GetRootComponent(), [this](USceneComponent * Component)
 	{
 		LevelOrderComponentTraverse(Component);
 		return false;
 	});
+
+	if (bCacheComponentLayout && !GAEComponentLayouts.Contains(GetClass()))
+	{
+		CacheComponentLayout();
+	}
+}
+
+bool AAEPhysicalActor::ReplicateSubobjects(UActorChannel * Channel, FOutBunch * Bunch, FReplicationFlags * RepFlags)
+{
+	bool bWroteSomething = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
+
+	for (UAEStateManager * StateManager : ReplicatedStateManagers)
+	{
+		if (StateManager)
+		{
+			bWroteSomething |= StateManager->ReplicateNetState(Channel, Bunch, RepFlags);
+		}
+	}
+
+	return bWroteSomething;
+}
+
+#if WITH_EDITOR
+EDataValidationResult AAEPhysicalActor::IsDataValid(TArray<FText>& ValidationErrors)
+{
+	EDataValidationResult Result = Super::IsDataValid(ValidationErrors);
+
+	TArray<UObject *> Subobjects;
+	GetObjectsWithOuter(this, Subobjects, false);
+
+	for (UObject * Subobject : Subobjects)
+	{
+		UAEStateManager * StateManager = Cast<UAEStateManager>(Subobject);
+
+		if (StateManager && StateManager->IsDataValid(ValidationErrors) == EDataValidationResult::Invalid)
+		{
+			Result = EDataValidationResult::Invalid;
+		}
+	}
+
+	return Result;
+}
+#endif // WITH_EDITOR
+
+bool AAEPhysicalActor::ApplyCachedComponentLayout()
+{
+	const FAEComponentLayout * Layout = GAEComponentLayouts.Find(GetClass());
+
+	if (!Layout || !Layout->bCanUseLayout || GetComponents().Num() != Layout->NumComponents)
+	{
+		return false;
+	}
+
+	//components are outered to the actor, so finding them by name is a hash lookup
+	USkeletalMeshComponent * FoundSkeletalMesh = NULL;
+
+	if (Layout->SkeletalMeshName != NAME_None)
+	{
+		FoundSkeletalMesh = FindObjectFast<USkeletalMeshComponent>(this, Layout->SkeletalMeshName);
+
+		if (!FoundSkeletalMesh)
+		{
+			return false;
+		}
+	}
+
+	PhysicsComponents.Reset(Layout->PhysicsComponentNames.Num());
+
+	for (const FName& ComponentName : Layout->PhysicsComponentNames)
+	{
+		UPrimitiveComponent * PhysicsComponent = FindObjectFast<UPrimitiveComponent>(this, ComponentName);
+
+		//a placed instance can have physics turned off on a component that simulates in the class defaults
+		if (!PhysicsComponent || !PhysicsComponent->GetBodyInstance() || !PhysicsComponent->GetBodyInstance()->bSimulatePhysics)
+		{
+			PhysicsComponents.Reset();
+			return false;
+		}
+
+		PhysicsComponents.Add(PhysicsComponent);
+	}
+
+	SkeletalMesh = FoundSkeletalMesh;
+
+	return true;
+}
+
+void AAEPhysicalActor::CacheComponentLayout()
+{
+	FAEComponentLayout& Layout = GAEComponentLayouts.Add(GetClass());
+
+	//a Blueprint override lives in the Blueprint class instead of this one
+	UFunction * TraverseFunction = GetClass()->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(AAEPhysicalActor, LevelOrderComponentTraverse));
+	Layout.bCanUseLayout = TraverseFunction && TraverseFunction->GetOuter() == AAEPhysicalActor::StaticClass();
+
+	Layout.SkeletalMeshName = NAME_None;
+	Layout.NumComponents = GetComponents().Num();
+
+	if (SkeletalMesh)
+	{
+		Layout.bCanUseLayout &= SkeletalMesh->GetOuter() == this;
+		Layout.SkeletalMeshName = SkeletalMesh->GetFName();
+	}
+
+	for (UPrimitiveComponent * PhysicsComponent : PhysicsComponents)
+	{
+		Layout.bCanUseLayout &= PhysicsComponent->GetOuter() == this;
+		Layout.PhysicsComponentNames.Add(PhysicsComponent->GetFName());
+	}
 }
 
 void AAEPhysicalActor::LevelOrderComponentTraverse_Implementation(USceneComponent * Component)
@@ -39,8 +204,126 @@ void AAEPhysicalActor::LevelOrderComponentTraverse_Implementation(USceneComponen
 
 void AAEPhysicalActor::DestroyActorHeirarchy_Implementation()
 {
-	UAEGameplayStatics::DestroyAttachedActors(this);
+	//a pooled actor keeps its attached actors so they come back with it
+	if (AAEActorPool::ReleaseActor(this))
+	{
+		return;
+	}
+
+	AttachedActorsHelper(this, GetRootComponent(),
+		[](AActor * Actor)
+		{
+			if (AAEActorPool::ReleaseActor(Cast<AAEPhysicalActor>(Actor)))
+			{
+				return false;
+			}
+
+			Actor->Destroy();
+			return true;
+		});
+
 	Destroy();
+
+	NotifyAttachmentChanged();
+}
+
+void AAEPhysicalActor::DestroyActorHeirarchyDeferred()
+{
+	AAEActorDestructionQueue * DestructionQueue = AAEActorDestructionQueue::Get(GetWorld());
+
+	if (DestructionQueue)
+	{
+		DestructionQueue->Enqueue(this, true);
+	}
+	else
+	{
+		DestroyActorHeirarchy();
+	}
+}
+
+void AAEPhysicalActor::OnAcquiredFromPool_Implementation()
+{
+	TInlineComponentArray<UAEPhysicalActorAttachmentComponent *> AttachmentComponents(this);
+
+	for (UAEPhysicalActorAttachmentComponent * AttachmentComponent : AttachmentComponents)
+	{
+		//attachments released along with this actor are still attached, disconnected ones are respawned like on BeginPlay
+		if (AttachmentComponent->AttachedActor)
+		{
+			AttachmentComponent->ResetAttachmentToDefaultState();
+		}
+		else
+		{
+			AttachmentComponent->SpawnAttachmentIfNeeded();
+		}
+	}
+}
+
+void AAEPhysicalActor::OnReleasedToPool_Implementation()
+{
+}
+
+void AAEPhysicalActor::NotifyAttachmentChanged()
+{
+	//skip 0 so a freshly constructed actor's cache is always stale
+	if (++AttachmentGeneration == 0)
+	{
+		AttachmentGeneration = 1;
+	}
+}
+
+bool AAEPhysicalActor::IsAttachedActorCacheValid() const
+{
+	return AttachedActorCacheGeneration == AttachmentGeneration
+		&& AttachedActorCacheRoot == GetRootComponent();
+}
+
+void AAEPhysicalActor::UpdateAttachedActorCache()
+{
+	AttachedActorCache.Reset();
+	AttachedActorCacheRoot = GetRootComponent();
+	AttachedActorCacheGeneration = AttachmentGeneration;
+
+	struct FPendingComponent
+	{
+		AActor * Actor;
+		USceneComponent * Component;
+		int32 Depth;
+	};
+
+	//same walk as AttachedActorsHelper, but keeping track of how deep each attached actor is
+	TArray<FPendingComponent, TInlineAllocator<AE_COMPONENT_TRAVERSAL_INLINE_SIZE>> Pending;
+	Pending.Add({ this, GetRootComponent(), 0 });
+
+	while (Pending.Num() > 0)
+	{
+		const FPendingComponent Curr = Pending.Pop(false);
+
+		if (!Curr.Component)
+		{
+			continue;
+		}
+
+		AActor * ComponentOwner = Curr.Component->GetOwner();
+
+		if (ComponentOwner != Curr.Actor)
+		{
+			FAEAttachedActorCacheEntry& Entry = AttachedActorCache[AttachedActorCache.AddDefaulted()];
+			Entry.Actor = ComponentOwner;
+			Entry.PhysicalActor = Cast<AAEPhysicalActor>(ComponentOwner);
+			Entry.Depth = Curr.Depth + 1;
+
+			Pending.Add({ ComponentOwner, Curr.Component, Entry.Depth });
+			continue;
+		}
+
+		const TArray<USceneComponent *>& Children = Curr.Component->GetAttachChildren();
+
+		for (int32 ChildInd = Children.Num() - 1; ChildInd >= 0; --ChildInd)
+		{
+			Pending.Add({ Curr.Actor, Children[ChildInd], Curr.Depth });
+		}
+	}
 }
 
 void AAEPhysicalActor::SetActorHeirarchyHiddenInGame_Implementation(bool bNewHidden)
@@ -50,25 +333,53 @@ void AAEPhysicalActor::SetActorHeirarchyHiddenInGame_Implementation(bool bNewHid
 		bForceHeirarchyHiddenInGame = false;
 	}
 
-	SetActorHiddenInGame(bNewHidden);
-	UAEGameplayStatics::SetAttachedActorsHiddenInGame(this, bNewHidden);
+	AAEActorStateBatcher::RequestActorHiddenInGame(this, bNewHidden);
+
+	ForEachAttachedActor([bNewHidden](AActor * Actor, AAEPhysicalActor * PhysActor)
+	{
+		if (!bNewHidden && PhysActor && PhysActor->bForceHeirarchyHiddenInGame)
+		{
+			return false;
+		}
+
+		AAEActorStateBatcher::RequestActorHiddenInGame(Actor, bNewHidden);
+		return true;
+	});
 }
 
 void AAEPhysicalActor::SetActorHeirarchyEnableCollision_Implementation(bool bNewCollision)
 {
-	SetActorEnableCollision(bNewCollision);
-	UAEGameplayStatics::SetAttachedActorsEnableCollision(this, bNewCollision);
+	AAEActorStateBatcher::RequestActorEnableCollision(this, bNewCollision);
+
+	ForEachAttachedActor([bNewCollision](AActor * Actor, AAEPhysicalActor * PhysActor)
+	{
+		if (bNewCollision && PhysActor && PhysActor->bForceHeirarchyCollisionDisabled)
+		{
+			return false;
+		}
+
+		AAEActorStateBatcher::RequestActorEnableCollision(Actor, bNewCollision);
+		return true;
+	});
 }
 
 void AAEPhysicalActor::SetActorHeirarchyPhysicsEnabled_Implementation(bool bNewPhysics)
 {
+	//pending collision changes have to be in place before bodies start simulating
+	if (bNewPhysics)
+	{
+		AAEActorStateBatcher * StateBatcher = AAEActorStateBatcher::Get(GetWorld());
+
+		if (StateBatcher)
+		{
+			StateBatcher->Flush();
+		}
+	}
+
 	SetPhysicsEnabled(bNewPhysics);
 
-	AttachedActorsHelper(this, GetRootComponent(),
-		[bNewPhysics](AActor * Actor)
+	ForEachAttachedActor([bNewPhysics](AActor * Actor, AAEPhysicalActor * PhysActor)
 	{
-		AAEPhysicalActor * PhysActor = Cast<AAEPhysicalActor>(Actor);
-
 		if (PhysActor)
 		{
 			if (PhysActor->bForceHeirarchyPhysicsDisabled)
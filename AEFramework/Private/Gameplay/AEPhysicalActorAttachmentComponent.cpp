@@ -1,45 +1,175 @@
 #include "AEPhysicalActorAttachmentComponent.h"
 
+#include "Engine/AssetManager.h"
+
+#include "AEActorPool.h"
+#include "AEEventLog.h"
+
 UAEPhysicalActorAttachmentComponent::UAEPhysicalActorAttachmentComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
+	PoolPrewarmCount = 0;
+	bSpawnAttachmentWhenLoaded = false;
+}
+
+/**
+The asset manager's streamable manager if the project has one, otherwise one owned by the module.
+*/
+static FStreamableManager& GetAEStreamableManager()
+{
+	if (UAssetManager::IsValid())
+	{
+		return UAssetManager::GetStreamableManager();
+	}
+
+	static FStreamableManager StreamableManager;
+	return StreamableManager;
 }
 
 void UAEPhysicalActorAttachmentComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
+	PrewarmAttachmentPool();
+
 	SpawnAttachmentIfNeeded();
 }
 
+void UAEPhysicalActorAttachmentComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (AttachedActorClassHandle.IsValid())
+	{
+		//don't spawn anything once the load finishes
+		if (AttachedActorClassHandle->IsLoadingInProgress())
+		{
+			AttachedActorClassHandle->CancelHandle();
+		}
+
+		AttachedActorClassHandle.Reset();
+	}
+
+	bSpawnAttachmentWhenLoaded = false;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UAEPhysicalActorAttachmentComponent::PrewarmAttachmentPool()
+{
+	TSubclassOf<AAEPhysicalActor> ActorClass = GetAttachedActorClass();
+
+	if (PoolPrewarmCount > 0 && ActorClass && ActorClass->GetDefaultObject<AAEPhysicalActor>()->bUseActorPool)
+	{
+		AAEActorPool * Pool = AAEActorPool::Get(GetWorld());
+
+		if (Pool)
+		{
+			Pool->Prewarm(ActorClass, PoolPrewarmCount);
+		}
+	}
+}
+
 ////////////////////////////////////
 //Attachment
 
 void UAEPhysicalActorAttachmentComponent::SpawnAttachmentIfNeeded_Implementation(bool bForceSpawn)
 {
-	if (!AttachedActor && AttachedActorClass)
+	if (!AttachedActor && HasAttachedActorClass())
 	{
 		if (bForceSpawn || ShouldSpawnAttachment())
 		{
+			if (!GetAttachedActorClass())
+			{
+				if (!bForceSpawn)
+				{
+					LoadAttachedActorClassAsync(true);
+					return;
+				}
+
+				//the caller uses the attachment right after this so it can't wait for streaming
+				SoftAttachedActorClass.LoadSynchronous();
+			}
+
 			SpawnAttachment();
 			ResetAttachmentToDefaultState();
+
+			if (AttachedActor)
+			{
+				OnAttachmentSpawned.Broadcast(this, AttachedActor);
+			}
+		}
+		else if (ShouldPrefetchAttachment())
+		{
+			PrefetchAttachment();
 		}
 	}
 }
 
+TSubclassOf<AAEPhysicalActor> UAEPhysicalActorAttachmentComponent::GetAttachedActorClass() const
+{
+	if (AttachedActorClass)
+	{
+		return AttachedActorClass;
+	}
+
+	return SoftAttachedActorClass.Get();
+}
+
+void UAEPhysicalActorAttachmentComponent::PrefetchAttachment()
+{
+	LoadAttachedActorClassAsync(false);
+}
+
+void UAEPhysicalActorAttachmentComponent::LoadAttachedActorClassAsync(bool bSpawnWhenLoaded)
+{
+	if (AttachedActorClass || SoftAttachedActorClass.IsNull())
+	{
+		return;
+	}
+
+	if (bSpawnWhenLoaded)
+	{
+		bSpawnAttachmentWhenLoaded = true;
+	}
+
+	//already requested, the pending load picks up bSpawnAttachmentWhenLoaded
+	if (AttachedActorClassHandle.IsValid())
+	{
+		return;
+	}
+
+	AttachedActorClassHandle = GetAEStreamableManager().RequestAsyncLoad(SoftAttachedActorClass.ToSoftObjectPath(),
+		FStreamableDelegate::CreateUObject(this, &UAEPhysicalActorAttachmentComponent::OnAttachedActorClassLoaded));
+}
+
+void UAEPhysicalActorAttachmentComponent::OnAttachedActorClassLoaded()
+{
+	PrewarmAttachmentPool();
+
+	if (bSpawnAttachmentWhenLoaded)
+	{
+		bSpawnAttachmentWhenLoaded = false;
+
+		//asks ShouldSpawnAttachment again since things may have changed while loading
+		SpawnAttachmentIfNeeded();
+	}
+}
+
 bool UAEPhysicalActorAttachmentComponent::ShouldSpawnAttachment_Implementation() const
 {
 	return GetDefaultVisibility() && GetDefaultCollision();
 }
 
-void UAEPhysicalActorAttachmentComponent::SpawnAttachment_Implementation()
+bool UAEPhysicalActorAttachmentComponent::ShouldPrefetchAttachment_Implementation() const
 {
-	FActorSpawnParameters SpawnParams;
+	return false;
+}
 
-	SpawnParams.Owner = GetOwner();
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+void UAEPhysicalActorAttachmentComponent::SpawnAttachment_Implementation()
+{
+	//reuses a pooled actor if AttachedActorClass has bUseActorPool set
+	AttachedActor = AAEActorPool::SpawnOrAcquireActor(GetWorld(), GetAttachedActorClass(), FTransform::Identity, GetOwner());
 
-	AttachedActor = GetWorld()->SpawnActor<AAEPhysicalActor>(AttachedActorClass, SpawnParams);
+	AE_RECORD_EVENT(ATTACHMENT_SPAWN, GetOwner()->GetFName(), AttachedActor ? AttachedActor->GetFName() : NAME_None, AttachComponentSocket);
 }
 
 void UAEPhysicalActorAttachmentComponent::ResetAttachmentToDefaultState_Implementation()
@@ -72,12 +202,17 @@ AAEPhysicalActor * UAEPhysicalActorAttachmentComponent::DisconnectAttachment_Imp
 				
 		AttachedActor = NULL;
 
+		AE_RECORD_EVENT(ATTACHMENT_DISCONNECT, GetOwner()->GetFName(), Res->GetFName(), AttachComponentSocket);
+
 		Res->SetOwner(NULL);
 
 		Res->SetActorHeirarchyEnableCollision(true);
 		Res->SetActorHeirarchyPhysicsEnabled(true);
 		Res->SetActorHeirarchyHiddenInGame(false);
 
+		//enabling physics detaches it from the owner
+		AAEPhysicalActor::NotifyAttachmentChanged();
+
 		return Res;
 	}
 
@@ -1,7 +1,155 @@
 #include "AEState.h"
 
+#include "LatentActions.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+
 #include "AEStateManager.h"
 
+/**
+Latent action backing the UAEState waits.
+Either triggers a Blueprint output link or calls a native continuation.
+*/
+class FAEStateWaitAction : public FPendingLatentAction
+{
+public:
+	enum class EWaitType : uint8
+	{
+		Delay,
+		MontageEnd,
+		StateEvent
+	};
+
+	FAEStateWaitAction(UAEState * InState, EWaitType InWaitType)
+		: State(InState),
+		WaitGeneration(InState->WaitGeneration),
+		WaitType(InWaitType),
+		TimeRemaining(0.f),
+		EventCount(0),
+		OutputLink(INDEX_NONE)
+	{}
+
+	virtual void UpdateOperation(FLatentResponse& Response) override
+	{
+		//cleared by ClearLatentActions, or the state went inactive some other way
+		if (IsCleared() || !State->GetIsActive())
+		{
+			Response.DoneIf(true);
+			return;
+		}
+
+		bool bDone = false;
+
+		switch (WaitType)
+		{
+		case EWaitType::Delay:
+			TimeRemaining -= Response.ElapsedTime();
+			bDone = TimeRemaining <= 0.f;
+			break;
+
+		case EWaitType::MontageEnd:
+			bDone = !AnimInstance.IsValid() || !Montage.IsValid() || !AnimInstance->Montage_IsPlaying(Montage.Get());
+			break;
+
+		case EWaitType::StateEvent:
+			bDone = State->GetStateEventCount(EventName) > EventCount;
+			break;
+		}
+
+		if (!bDone)
+		{
+			return;
+		}
+
+		if (Continuation)
+		{
+			Response.DoneIf(true);
+
+			//the latent action manager is iterating this state's actions right now, and a continuation
+			//that transitions or starts another wait would change them, so it runs next tick instead
+			State->SetStateTimerForNextTick(MoveTemp(Continuation));
+		}
+		else
+		{
+			Response.FinishAndTriggerIf(true, ExecutionFunction, OutputLink, CallbackTarget);
+		}
+	}
+
+	bool IsCleared() const
+	{
+		return !State.IsValid() || State->WaitGeneration != WaitGeneration;
+	}
+
+	TWeakObjectPtr<UAEState> State;
+	uint32 WaitGeneration;
+	EWaitType WaitType;
+
+	float TimeRemaining;
+
+	TWeakObjectPtr<UAnimInstance> AnimInstance;
+	TWeakObjectPtr<UAnimMontage> Montage;
+
+	FName EventName;
+	int32 EventCount;
+
+	TFunction<void()> Continuation;
+
+	FName ExecutionFunction;
+	int32 OutputLink;
+	FWeakObjectPtr CallbackTarget;
+};
+
+namespace AEStateLatent
+{
+	/**
+	Registers a wait with the latent action manager.
+	Blueprint waits use the LatentInfo, native waits get a UUID from the state.
+	*/
+	FORCEINLINE_DEBUGGABLE void AddWaitAction(UAEState * State, int32 UUID, FAEStateWaitAction * Action, const FLatentActionInfo * LatentInfo)
+	{
+		FLatentActionManager& LatentActionManager = State->GetWorld()->GetLatentActionManager();
+
+		if (LatentInfo)
+		{
+			Action->ExecutionFunction = LatentInfo->ExecutionFunction;
+			Action->OutputLink = LatentInfo->Linkage;
+			Action->CallbackTarget = LatentInfo->CallbackTarget;
+		}
+
+		//looked up on the state, which is where the actions are registered
+		FAEStateWaitAction * ExistingAction = LatentActionManager.FindExistingAction<FAEStateWaitAction>(State, UUID);
+
+		if (ExistingAction)
+		{
+			//a cleared wait that hasn't been removed yet gets reused, a wait that's still running isn't started twice
+			if (ExistingAction->IsCleared())
+			{
+				*ExistingAction = MoveTemp(*Action);
+			}
+
+			delete Action;
+			return;
+		}
+
+		LatentActionManager.AddNewAction(State, UUID, Action);
+	}
+}
+
+UAEState::UAEState(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer),
+	bClearAllObjectTimersOnInactive(true),
+	bWantsTick(true),
+	TickInterval(0.f),
+	StateIndex(INDEX_NONE),
+	StateClassId(INDEX_NONE),
+	StateTimerHandlesCompactSize(16),
+	NextNativeLatentUUID(0),
+	WaitGeneration(0),
+	TimeSinceLastTick(0.f),
+	TickPhase(0.f)
+{
+}
+
 UWorld* UAEState::GetWorld() const
 {
 	if (HasAllFlags(RF_ClassDefaultObject))
@@ -13,6 +161,212 @@ UWorld* UAEState::GetWorld() const
     return GetOuterUAEStateManager()->GetWorld();
 }
 
+int32 UAEState::GetStateClassId(UClass * StateClass)
+{
+	static int32 NextStateClassId = 0;
+
+	if (!StateClass)
+	{
+		return INDEX_NONE;
+	}
+
+	UAEState * DefaultState = StateClass->GetDefaultObject<UAEState>();
+
+	if (DefaultState->StateClassId == INDEX_NONE)
+	{
+		DefaultState->StateClassId = NextStateClassId++;
+	}
+
+	return DefaultState->StateClassId;
+}
+
+void UAEState::ResetTickInterval()
+{
+	if (TickInterval > 0.f)
+	{
+		//golden ratio sequence so consecutive states starting on the same frame land on different frames
+		static uint32 StaggerCounter = 0;
+		TickPhase = FMath::Frac(++StaggerCounter * 0.618034f) * TickInterval;
+	}
+	else
+	{
+		TickPhase = 0.f;
+	}
+
+	TimeSinceLastTick = 0.f;
+}
+
+void UAEState::SetStateTimer(FTimerHandle& InOutHandle, const FTimerDelegate& Delegate, float Rate, bool bLoop, float FirstDelay)
+{
+	//setting a timer on an existing handle replaces it so stop tracking the old one
+	if (InOutHandle.IsValid())
+	{
+		StateTimerHandles.RemoveSwap(InOutHandle);
+	}
+
+	GetWorld()->GetTimerManager().SetTimer(InOutHandle, Delegate, Rate, bLoop, FirstDelay);
+
+	TrackStateTimer(InOutHandle);
+}
+
+void UAEState::TrackStateTimer(const FTimerHandle& Handle)
+{
+	if (!Handle.IsValid())
+	{
+		return;
+	}
+
+	if (StateTimerHandles.Num() >= StateTimerHandlesCompactSize)
+	{
+		FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+
+		for (int32 HandleInd = StateTimerHandles.Num() - 1; HandleInd >= 0; --HandleInd)
+		{
+			if (!TimerManager.TimerExists(StateTimerHandles[HandleInd]))
+			{
+				StateTimerHandles.RemoveAtSwap(HandleInd, 1, false);
+			}
+		}
+
+		//amortizes the compaction if most of the timers are still running
+		StateTimerHandlesCompactSize = FMath::Max(16, StateTimerHandles.Num() * 2);
+	}
+
+	StateTimerHandles.Add(Handle);
+}
+
+void UAEState::SetStateTimerForNextTick(TFunction<void()> Callback)
+{
+	TWeakObjectPtr<UAEState> WeakState(this);
+
+	FTimerHandle Handle = GetWorld()->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateLambda([WeakState, Callback]()
+	{
+		if (WeakState.IsValid() && WeakState->GetIsActive())
+		{
+			Callback();
+		}
+	}));
+
+	TrackStateTimer(Handle);
+}
+
+FTimerHandle UAEState::SetStateTimerByEvent(FTimerDynamicDelegate Event, float Time, bool bLooping)
+{
+	FTimerHandle Handle;
+
+	if (Event.IsBound())
+	{
+		GetWorld()->GetTimerManager().SetTimer(Handle, Event, Time, bLooping);
+
+		TrackStateTimer(Handle);
+	}
+
+	return Handle;
+}
+
+void UAEState::ClearStateTimer(FTimerHandle& Handle)
+{
+	if (Handle.IsValid())
+	{
+		StateTimerHandles.RemoveSwap(Handle);
+		GetWorld()->GetTimerManager().ClearTimer(Handle);
+	}
+}
+
+void UAEState::ClearStateTimers()
+{
+	if (StateTimerHandles.Num())
+	{
+		FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+
+		for (FTimerHandle& Handle : StateTimerHandles)
+		{
+			TimerManager.ClearTimer(Handle);
+		}
+
+		StateTimerHandles.Reset();
+	}
+}
+
+void UAEState::SendStateEvent(FName EventName)
+{
+	++StateEventCounts.FindOrAdd(EventName);
+}
+
+int32 UAEState::GetStateEventCount(FName EventName) const
+{
+	const int32 * Count = StateEventCounts.Find(EventName);
+	return Count ? *Count : 0;
+}
+
+void UAEState::K2_WaitForDelay(float Duration, FLatentActionInfo LatentInfo)
+{
+	FAEStateWaitAction * Action = new FAEStateWaitAction(this, FAEStateWaitAction::EWaitType::Delay);
+	Action->TimeRemaining = Duration;
+
+	AEStateLatent::AddWaitAction(this, LatentInfo.UUID, Action, &LatentInfo);
+}
+
+void UAEState::K2_WaitForMontageEnd(UAnimMontage * Montage, UAnimInstance * AnimInstance, FLatentActionInfo LatentInfo)
+{
+	FAEStateWaitAction * Action = new FAEStateWaitAction(this, FAEStateWaitAction::EWaitType::MontageEnd);
+	Action->Montage = Montage;
+	Action->AnimInstance = AnimInstance;
+
+	AEStateLatent::AddWaitAction(this, LatentInfo.UUID, Action, &LatentInfo);
+}
+
+void UAEState::K2_WaitForStateEvent(FName EventName, FLatentActionInfo LatentInfo)
+{
+	FAEStateWaitAction * Action = new FAEStateWaitAction(this, FAEStateWaitAction::EWaitType::StateEvent);
+	Action->EventName = EventName;
+	Action->EventCount = GetStateEventCount(EventName);
+
+	AEStateLatent::AddWaitAction(this, LatentInfo.UUID, Action, &LatentInfo);
+}
+
+void UAEState::WaitForDelay(float Duration, TFunction<void()> Continuation)
+{
+	FAEStateWaitAction * Action = new FAEStateWaitAction(this, FAEStateWaitAction::EWaitType::Delay);
+	Action->TimeRemaining = Duration;
+	Action->Continuation = MoveTemp(Continuation);
+
+	AEStateLatent::AddWaitAction(this, --NextNativeLatentUUID, Action, NULL);
+}
+
+void UAEState::WaitForMontageEnd(UAnimMontage * Montage, UAnimInstance * AnimInstance, TFunction<void()> Continuation)
+{
+	FAEStateWaitAction * Action = new FAEStateWaitAction(this, FAEStateWaitAction::EWaitType::MontageEnd);
+	Action->Montage = Montage;
+	Action->AnimInstance = AnimInstance;
+	Action->Continuation = MoveTemp(Continuation);
+
+	AEStateLatent::AddWaitAction(this, --NextNativeLatentUUID, Action, NULL);
+}
+
+void UAEState::WaitForStateEvent(FName EventName, TFunction<void()> Continuation)
+{
+	FAEStateWaitAction * Action = new FAEStateWaitAction(this, FAEStateWaitAction::EWaitType::StateEvent);
+	Action->EventName = EventName;
+	Action->EventCount = GetStateEventCount(EventName);
+	Action->Continuation = MoveTemp(Continuation);
+
+	AEStateLatent::AddWaitAction(this, --NextNativeLatentUUID, Action, NULL);
+}
+
+void UAEState::ClearLatentActions()
+{
+	//the latent action manager can't remove actions of one type, so the waits finish themselves on their next update
+	++WaitGeneration;
+	StateEventCounts.Reset();
+}
+
+uint8 * UAEState::GetSnapshotData(int32& OutSize)
+{
+	OutSize = 0;
+	return NULL;
+}
+
 void UAEState::Initialize_Implementation()
 {
 
@@ -24,6 +378,29 @@ bool UAEState::AllowInterruptionByState_Implementation(UAEState * State)
 	return true;
 }
 
+bool UAEState::EvaluateStaticInterruptionRules(const UAEState * State) const
+{
+	UClass * StateClass = State->GetClass();
+
+	for (const TSubclassOf<UAEState>& DeniedClass : DeniedInterruptingStates)
+	{
+		if (DeniedClass && StateClass->IsChildOf(DeniedClass))
+		{
+			return false;
+		}
+	}
+
+	for (const TSubclassOf<UAEState>& AllowedClass : AllowedInterruptingStates)
+	{
+		if (AllowedClass && StateClass->IsChildOf(AllowedClass))
+		{
+			return true;
+		}
+	}
+
+	return State->InterruptionPriority >= InterruptionPriority;
+}
+
 void UAEState::OnBegin_Implementation(UAEState * PreviousState)
 {
     check(GetIsActive());
@@ -1,30 +1,237 @@
 #include "AEStateManager.h"
 
+#include "Net/UnrealNetwork.h"
+#include "Engine/ActorChannel.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+
 #include "AELogging.h"
 #include "AEGameplayStatics.h"
 #include "AEState.h"
+#include "AEStateTickManager.h"
+#include "AEStateProfiler.h"
+#include "AEEventLog.h"
 
-bool UAEStateManager::Initialize_Implementation()
+TSharedPtr<const FAEStateLookupTable> FAEStateLookupTable::Build(const TArray<TSubclassOf<UAEState>>& StateClasses)
 {
-	bool bAnyErrors = false;
+	TSharedPtr<FAEStateLookupTable> Table = MakeShareable(new FAEStateLookupTable());
+
+	//register the class ids first so the flat lookup can be sized to cover them
+	int32 MinClassId = MAX_int32;
+	int32 MaxClassId = INDEX_NONE;
 
-	for (int32 StateInd = 0; StateInd < StateClasses.Num(); ++StateInd)
-	{		
-		//check if there's a state name with the class
-		if (StateClassToIndex.Contains(StateClasses[StateInd]))
+	for (const TSubclassOf<UAEState>& StateClass : StateClasses)
+	{
+		const int32 ClassId = UAEState::GetStateClassId(StateClass);
+
+		if (ClassId == INDEX_NONE)
 		{
-			UE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEStateManager named \"%s\" has a duplicate state with class \"%s\""), *GetName(), *StateClasses[StateInd]->GetName());
+			continue;
+		}
 
-			bAnyErrors = true;
+		MinClassId = FMath::Min(MinClassId, ClassId);
+		MaxClassId = FMath::Max(MaxClassId, ClassId);
+	}
+
+	Table->bUseFlatStateLookup = MaxClassId != INDEX_NONE
+		&& StateClasses.Num() <= MAX_int8
+		&& MaxClassId - MinClassId < MAX_FLAT_STATE_LOOKUP_SIZE;
+
+	if (Table->bUseFlatStateLookup)
+	{
+		Table->FlatStateLookupBaseClassId = MinClassId;
+		Table->FlatStateLookup.Init(INDEX_NONE, MaxClassId - MinClassId + 1);
+	}
+
+	for (const TSubclassOf<UAEState>& StateClass : StateClasses)
+	{
+		if (!StateClass)
+		{
+			continue;
+		}
+
+		if (Table->GetStateIndexForClass(StateClass) != INDEX_NONE)
+		{
+			Table->DuplicateStateClasses.Add(StateClass.Get());
+			continue;
+		}
+
+		//index into the unique classes rather than StateClasses so duplicates don't shift the lookup
+		const int32 StateIndex = Table->UniqueStateClasses.Add(StateClass.Get());
+
+		if (Table->bUseFlatStateLookup)
+		{
+			Table->FlatStateLookup[UAEState::GetStateClassId(StateClass) - Table->FlatStateLookupBaseClassId] = (int8)StateIndex;
 		}
 		else
 		{
-			StateClassToIndex.Add(StateClasses[StateInd], StateInd);
+			Table->StateClassToIndex.Add(StateClass.Get(), StateIndex);
+		}
+	}
+
+	//static interruption rules only depend on class defaults so they can be shared too
+	const int32 NumStates = Table->UniqueStateClasses.Num();
+
+	Table->InterruptionMatrix.Init(false, NumStates * NumStates);
+
+	for (int32 CurrentInd = 0; CurrentInd < NumStates; ++CurrentInd)
+	{
+		const UAEState * Current = Table->UniqueStateClasses[CurrentInd].Get()->GetDefaultObject<UAEState>();
+
+		if (!Current->bUseStaticInterruptionRules)
+		{
+			continue;
+		}
+
+		for (int32 InterruptingInd = 0; InterruptingInd < NumStates; ++InterruptingInd)
+		{
+			Table->InterruptionMatrix[CurrentInd * NumStates + InterruptingInd] = Current->EvaluateStaticInterruptionRules(Table->UniqueStateClasses[InterruptingInd].Get()->GetDefaultObject<UAEState>());
+		}
+	}
+
+	return Table;
+}
 
-			UAEState * State = NewObject<UAEState>(this, StateClasses[StateInd]);
-			StateInstances.Add(State);
+void FAEStateLookupTable::FindDuplicateStateClasses(const TArray<TSubclassOf<UAEState>>& StateClasses, TArray<UClass *>& OutDuplicateStateClasses)
+{
+	TSet<UClass *> SeenClasses;
 
-			State->Initialize();
+	for (const TSubclassOf<UAEState>& StateClass : StateClasses)
+	{
+		if (!StateClass)
+		{
+			continue;
+		}
+
+		bool bAlreadySeen = false;
+		SeenClasses.Add(StateClass, &bAlreadySeen);
+
+		if (bAlreadySeen)
+		{
+			OutDuplicateStateClasses.Add(StateClass);
+		}
+	}
+}
+
+bool FAEStateLookupTable::IsValid() const
+{
+	for (const TWeakObjectPtr<UClass>& StateClass : UniqueStateClasses)
+	{
+		if (!StateClass.IsValid())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int32 FAEStateLookupTable::GetStateIndexForClass(UClass * StateClass) const
+{
+	if (!StateClass)
+	{
+		return INDEX_NONE;
+	}
+
+	if (bUseFlatStateLookup)
+	{
+		//unregistered classes have an id of INDEX_NONE which also falls outside of the range
+		const int32 LookupInd = StateClass->GetDefaultObject<UAEState>()->StateClassId - FlatStateLookupBaseClassId;
+
+		return FlatStateLookup.IsValidIndex(LookupInd)
+			? FlatStateLookup[LookupInd]
+			: INDEX_NONE;
+	}
+
+	const int32 * Index = StateClassToIndex.Find(StateClass);
+
+	if (Index)
+	{
+		return *Index;
+	}
+	else
+	{
+		return -1;
+	}
+}
+
+TSharedPtr<const FAEStateLookupTable> UAEStateManager::GetSharedStateLookup()
+{
+	UAEStateManager * Archetype = Cast<UAEStateManager>(GetArchetype());
+
+	//instances that didn't change StateClasses share the archetype's table
+	if (Archetype && Archetype != this && Archetype->StateClasses == StateClasses)
+	{
+		if (!Archetype->StateLookup.IsValid() || !Archetype->StateLookup->IsValid())
+		{
+			Archetype->StateLookup = FAEStateLookupTable::Build(StateClasses);
+
+			for (const TWeakObjectPtr<UClass>& DuplicateClass : Archetype->StateLookup->DuplicateStateClasses)
+			{
+				UE_LOG(AE, Warning, TEXT("UAEStateManager archetype \"%s\" has a duplicate state with class \"%s\""), *Archetype->GetPathName(), *DuplicateClass->GetName());
+			}
+		}
+
+		return Archetype->StateLookup;
+	}
+
+	TSharedPtr<const FAEStateLookupTable> Table = FAEStateLookupTable::Build(StateClasses);
+
+	for (const TWeakObjectPtr<UClass>& DuplicateClass : Table->DuplicateStateClasses)
+	{
+		UE_LOG(AE, Warning, TEXT("UAEStateManager named \"%s\" has a duplicate state with class \"%s\""), *GetName(), *DuplicateClass->GetName());
+	}
+
+	return Table;
+}
+
+bool UAEStateManager::Initialize_Implementation()
+{
+	StateLookup = GetSharedStateLookup();
+
+	bool bAnyErrors = StateLookup->DuplicateStateClasses.Num() > 0;
+
+	StateInstances.Reserve(StateLookup->UniqueStateClasses.Num());
+
+	for (const TWeakObjectPtr<UClass>& StateClass : StateLookup->UniqueStateClasses)
+	{
+		UAEState * State = NewObject<UAEState>(this, StateClass.Get());
+		State->StateIndex = StateInstances.Add(State);
+		State->Initialize();
+	}
+
+	SnapshotSize = sizeof(FAEStateManagerSnapshotHeader);
+
+	for (UAEState * State : StateInstances)
+	{
+		FAEStateSnapshotBlock Block;
+		Block.Data = State->GetSnapshotData(Block.Size);
+
+		if (Block.Data && Block.Size > 0)
+		{
+			StateSnapshotBlocks.Add(Block);
+			SnapshotSize += Block.Size;
+		}
+	}
+
+	if (bTickFromTickManager)
+	{
+		RegisterWithTickManager();
+	}
+
+	if (bReplicateStates)
+	{
+		if (StateInstances.Num() > FAEStateManagerNetState::NO_STATE)
+		{
+			AE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEStateManager named \"%s\" replicates states but has more than %d states.  The extra states can't be replicated."), *GetName(), (int32)FAEStateManagerNetState::NO_STATE);
+
+			bAnyErrors = true;
+		}
+
+		//the net state may have arrived before the states existed
+		if (!HasNetAuthority())
+		{
+			OnRep_NetState();
 		}
 	}
 
@@ -33,9 +240,60 @@ bool UAEStateManager::Initialize_Implementation()
 
 void UAEStateManager::Tick_Implementation(float DeltaTime)
 {
-	if (CurrentState && CurrentState->bIsActive)
+	float StateDeltaTime;
+
+	if (CurrentState && CurrentState->bIsActive && CurrentState->ShouldTick(DeltaTime, StateDeltaTime))
+	{
+		AE_STATE_PROFILE_SCOPE(CurrentState->GetClass(), TICK);
+
+		CurrentState->Tick(StateDeltaTime);
+	}
+
+	ApplyPendingTransition();
+}
+
+void UAEStateManager::RegisterWithTickManager()
+{
+	AAEStateTickManager * TickManager = AAEStateTickManager::Get(GetWorld());
+
+	if (TickManager)
+	{
+		TickManager->RegisterStateManager(this);
+	}
+}
+
+void UAEStateManager::UnregisterFromTickManager()
+{
+	if (bRegisteredWithTickManager)
+	{
+		AAEStateTickManager * TickManager = AAEStateTickManager::Get(GetWorld());
+
+		if (TickManager)
+		{
+			TickManager->UnregisterStateManager(this);
+		}
+	}
+}
+
+void UAEStateManager::ClearTimersAndLatentActions()
+{
+	UWorld * World = GetWorld();
+
+	if (!World)
 	{
-		CurrentState->Tick(DeltaTime);
+		return;
+	}
+
+	PendingState = NULL;
+	bHasPendingTransition = false;
+	bHasPendingPredictionKey = false;
+
+	for (UAEState * State : StateInstances)
+	{
+		State->ClearStateTimers();
+
+		World->GetTimerManager().ClearAllTimersForObject(State);
+		World->GetLatentActionManager().RemoveActionsForObject(State);
 	}
 }
 
@@ -43,19 +301,74 @@ void UAEStateManager::ForceGotoState(UAEState * State)
 {
 	if (State && State->GetOuterUAEStateManager() != this)
 	{
-		UE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEStateManager named \"%s\" has GotoState being called with a State that wasn't spawned by this manager.  This call won't take effect."), *GetName());
+		AE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEStateManager named \"%s\" has GotoState being called with a State that wasn't spawned by this manager.  This call won't take effect."), *GetName());
 
 		return;
 	}
 
+	if (bDeferTransitions)
+	{
+		if (bHasPendingTransition && TransitionCoalescing == AEStateTransitionCoalescing::HIGHEST_PRIORITY_WINS)
+		{
+			const int32 PendingPriority = PendingState ? PendingState->InterruptionPriority : 0;
+			const int32 Priority = State ? State->InterruptionPriority : 0;
+
+			if (Priority < PendingPriority)
+			{
+				return;
+			}
+		}
+
+		PendingState = State;
+		bHasPendingTransition = true;
+		return;
+	}
+
+	PerformGotoState(State);
+}
+
+void UAEStateManager::ApplyPendingTransition()
+{
+	if (!bHasPendingTransition)
+	{
+		return;
+	}
+
+	UAEState * State = PendingState;
+
+	//clear first so requests made by the transition's callbacks queue up for the next tick
+	PendingState = NULL;
+	bHasPendingTransition = false;
+
+	if (bHasPendingPredictionKey)
+	{
+		AcknowledgedPredictionKey = PendingPredictionKey;
+		bHasPendingPredictionKey = false;
+		MarkNetStateDirty();
+	}
+
+	if (State && State == CurrentState && State->bIsActive)
+	{
+		return;
+	}
+
+	PerformGotoState(State);
+}
+
+void UAEStateManager::PerformGotoState(UAEState * State)
+{
 	if (CurrentState)
 	{
 		if (CurrentState->bIsActive)
 		{
+			AE_STATE_PROFILE_SCOPE(CurrentState->GetClass(), INTERRUPT);
+
 			CurrentState->OnInterrupt(State);
 			CurrentState->BecomeInactive();
 		}
 
+		AE_STATE_PROFILE_SCOPE(CurrentState->GetClass(), END);
+
 		CurrentState->OnEnd(State);
 	}
 		
@@ -63,9 +376,26 @@ void UAEStateManager::ForceGotoState(UAEState * State)
 
 	CurrentState = State;
 
+	++TransitionCount;
+
+	AE_RECORD_EVENT(STATE_TRANSITION, GetOuter()->GetFName(),
+		PrevState ? PrevState->GetClass()->GetFName() : NAME_None,
+		CurrentState ? CurrentState->GetClass()->GetFName() : NAME_None);
+
+	if (bReplicateStates && HasNetAuthority())
+	{
+		NetState.StateIndex = CurrentState ? (uint8)CurrentState->StateIndex : FAEStateManagerNetState::NO_STATE;
+		++NetState.TransitionCount;
+		MarkNetStateDirty();
+	}
+
 	if (CurrentState)
 	{
 		CurrentState->bIsActive = true;
+		CurrentState->ResetTickInterval();
+
+		AE_STATE_PROFILE_SCOPE(CurrentState->GetClass(), BEGIN);
+
 		CurrentState->OnBegin(PrevState);
 	}
 }
@@ -95,34 +425,331 @@ bool UAEStateManager::AllowInterruptionByState(UAEState * State)
 
 	if (State->GetOuterUAEStateManager() != this)
 	{
-		UE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEStateManager named \"%s\" has AllowInterruptionByState being called with a State that wasn't spawned by this manager.  This call won't take effect."), *GetName());
+		AE_LOG_ON_SCREEN(AE, Warning, 5.f, FColor::Red, TEXT("UAEStateManager named \"%s\" has AllowInterruptionByState being called with a State that wasn't spawned by this manager.  This call won't take effect."), *GetName());
 
 		return false;
 	}
 
 	if (CurrentState && CurrentState->bIsActive)
 	{
+		if (CurrentState->bUseStaticInterruptionRules)
+		{
+			return StateLookup->InterruptionMatrix[CurrentState->StateIndex * StateInstances.Num() + State->StateIndex];
+		}
+
 		return CurrentState->AllowInterruptionByState(State);
 	}
 
 	return true;
 }
 
+void UAEStateManager::SendStateEvent(FName EventName)
+{
+	if (CurrentState && CurrentState->bIsActive)
+	{
+		CurrentState->SendStateEvent(EventName);
+	}
+}
+
 int32 UAEStateManager::GetStateIndexForClass(TSubclassOf<UAEState> StateClass) const
 {
-	const int32 * Index = StateClassToIndex.Find(StateClass);
+	return StateLookup.IsValid()
+		? StateLookup->GetStateIndexForClass(StateClass)
+		: INDEX_NONE;
+}
 
-	if (Index)
+#if WITH_EDITOR
+void UAEStateManager::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(UAEStateManager, StateClasses))
 	{
-		return *Index;
+		//rebuilt from the new classes the next time an instance is initialized
+		StateLookup.Reset();
 	}
-	else
+}
+
+EDataValidationResult UAEStateManager::IsDataValid(TArray<FText>& ValidationErrors)
+{
+	EDataValidationResult Result = Super::IsDataValid(ValidationErrors);
+
+	TArray<UClass *> DuplicateStateClasses;
+	FAEStateLookupTable::FindDuplicateStateClasses(StateClasses, DuplicateStateClasses);
+
+	for (UClass * DuplicateClass : DuplicateStateClasses)
 	{
-		return -1;
+		ValidationErrors.Add(FText::Format(NSLOCTEXT("AEStateManager", "DuplicateStateClass", "State manager {0} has a duplicate state with class {1}.  Each state class should only be added once."),
+			FText::FromString(GetPathName()),
+			FText::FromString(DuplicateClass->GetName())));
 	}
+
+	if (DuplicateStateClasses.Num() > 0)
+	{
+		Result = EDataValidationResult::Invalid;
+	}
+	else if (Result == EDataValidationResult::NotValidated)
+	{
+		Result = EDataValidationResult::Valid;
+	}
+
+	return Result;
 }
+#endif // WITH_EDITOR
 
 UAEState * UAEStateManager::GetStateForClass(TSubclassOf<UAEState> StateClass) const
 {
 	return GetStateForIndex(GetStateIndexForClass(StateClass));
-}
\ No newline at end of file
+}
+
+/////////////////////////////////////// 
+//Snapshots
+
+int32 UAEStateManager::GetSnapshotSize() const
+{
+	return SnapshotSize;
+}
+
+void UAEStateManager::SaveSnapshot(uint8 * OutBuffer) const
+{
+	FAEStateManagerSnapshotHeader Header;
+	Header.CurrentStateIndex = CurrentState ? (int16)CurrentState->StateIndex : (int16)INDEX_NONE;
+	Header.PendingStateIndex = PendingState ? (int16)PendingState->StateIndex : (int16)INDEX_NONE;
+	Header.bCurrentStateActive = CurrentState && CurrentState->bIsActive;
+	Header.bHasPendingTransition = bHasPendingTransition;
+	Header.TimeSinceLastTick = CurrentState ? CurrentState->TimeSinceLastTick : 0.f;
+	Header.TickPhase = CurrentState ? CurrentState->TickPhase : 0.f;
+
+	FMemory::Memcpy(OutBuffer, &Header, sizeof(Header));
+	OutBuffer += sizeof(Header);
+
+	for (const FAEStateSnapshotBlock& Block : StateSnapshotBlocks)
+	{
+		FMemory::Memcpy(OutBuffer, Block.Data, Block.Size);
+		OutBuffer += Block.Size;
+	}
+}
+
+void UAEStateManager::RestoreSnapshot(const uint8 * Buffer)
+{
+	FAEStateManagerSnapshotHeader Header;
+	FMemory::Memcpy(&Header, Buffer, sizeof(Header));
+	Buffer += sizeof(Header);
+
+	//only the current state can be active
+	if (CurrentState)
+	{
+		CurrentState->bIsActive = false;
+	}
+
+	CurrentState = GetStateForIndex(Header.CurrentStateIndex);
+
+	if (CurrentState)
+	{
+		CurrentState->bIsActive = Header.bCurrentStateActive != 0;
+		CurrentState->TimeSinceLastTick = Header.TimeSinceLastTick;
+		CurrentState->TickPhase = Header.TickPhase;
+	}
+
+	PendingState = GetStateForIndex(Header.PendingStateIndex);
+	bHasPendingTransition = Header.bHasPendingTransition != 0;
+
+	for (const FAEStateSnapshotBlock& Block : StateSnapshotBlocks)
+	{
+		FMemory::Memcpy(Block.Data, Buffer, Block.Size);
+		Buffer += Block.Size;
+	}
+}
+
+void UAEStateManager::SaveSnapshot(TArray<uint8>& OutBuffer) const
+{
+	OutBuffer.SetNumUninitialized(SnapshotSize, false);
+	SaveSnapshot(OutBuffer.GetData());
+}
+
+void UAEStateManager::RestoreSnapshot(const TArray<uint8>& Buffer)
+{
+	check(Buffer.Num() >= SnapshotSize);
+	RestoreSnapshot(Buffer.GetData());
+}
+
+/////////////////////////////////////// 
+//Networking
+
+bool UAEStateManager::HasNetAuthority() const
+{
+	return GetOuterAActor()->HasAuthority();
+}
+
+void UAEStateManager::MarkNetStateDirty()
+{
+	++NetStateVersion;
+	GetOuterAActor()->ForceNetUpdate();
+}
+
+bool UAEStateManager::PredictGotoState(UAEState * State)
+{
+	if (!bReplicateStates || HasNetAuthority())
+	{
+		return TryGotoState(State);
+	}
+
+	if (State && State->GetOuterUAEStateManager() != this)
+	{
+		return false;
+	}
+
+	if (!AllowInterruptionByState(State))
+	{
+		return false;
+	}
+
+	++LocalPredictionKey;
+	ForceGotoState(State);
+
+	ServerPredictGotoState(State ? (uint8)State->StateIndex : FAEStateManagerNetState::NO_STATE, LocalPredictionKey);
+
+	return true;
+}
+
+bool UAEStateManager::ServerPredictGotoState_Validate(uint8 StateIndex, uint8 PredictionKey)
+{
+	return StateIndex == FAEStateManagerNetState::NO_STATE || StateIndex < StateInstances.Num();
+}
+
+void UAEStateManager::ServerPredictGotoState_Implementation(uint8 StateIndex, uint8 PredictionKey)
+{
+	UAEState * State = StateIndex == FAEStateManagerNetState::NO_STATE
+		? NULL
+		: StateInstances[StateIndex];
+
+	if (!TryGotoState(State))
+	{
+		AcknowledgedPredictionKey = PredictionKey;
+
+		//bump the count so the rejected client gets a correction even though the state didn't change
+		++NetState.TransitionCount;
+		MarkNetStateDirty();
+	}
+	else if (bHasPendingTransition)
+	{
+		//acknowledged once the transition is applied so the ack doesn't reach the client ahead of the state
+		PendingPredictionKey = PredictionKey;
+		bHasPendingPredictionKey = true;
+	}
+	else
+	{
+		AcknowledgedPredictionKey = PredictionKey;
+		MarkNetStateDirty();
+	}
+}
+
+void UAEStateManager::OnRep_NetState()
+{
+	//the server hasn't seen our latest prediction yet so this is older than what we predicted.
+	//both keys stay 0 on other clients since they never predict and don't receive AcknowledgedPredictionKey
+	if (AcknowledgedPredictionKey != LocalPredictionKey)
+	{
+		return;
+	}
+
+	UAEState * ServerState = NULL;
+
+	if (NetState.StateIndex != FAEStateManagerNetState::NO_STATE)
+	{
+		if (!StateInstances.IsValidIndex(NetState.StateIndex))
+		{
+			//not initialized yet, Initialize calls this again
+			return;
+		}
+
+		ServerState = StateInstances[NetState.StateIndex];
+	}
+
+	if (ServerState != CurrentState)
+	{
+		//corrections skip deferral, they need to take effect right away
+		PerformGotoState(ServerState);
+	}
+}
+
+bool UAEStateManager::ReplicateNetState(UActorChannel * Channel, FOutBunch * Bunch, FReplicationFlags * RepFlags)
+{
+	if (!bReplicateStates)
+	{
+		return false;
+	}
+
+	FAEStateManagerChannelInfo * ChannelInfo = NetStateChannels.Find(Channel);
+
+	if (!ChannelInfo)
+	{
+		//drop closed channels when adding new ones so the map doesn't grow over the actor's lifetime
+		for (auto It = NetStateChannels.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		ChannelInfo = &NetStateChannels.Add(Channel);
+	}
+	else if (!RepFlags->bNetInitial && ChannelInfo->SentVersion == NetStateVersion && ChannelInfo->UnackedPacketId == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const bool bWroteSomething = Channel->ReplicateSubobject(this, *Bunch, *RepFlags);
+
+	ChannelInfo->SentVersion = NetStateVersion;
+
+	//the bunch can go out in the packet after OutPacketId, so wait until that one is acked too.
+	//Acks and NAKs are processed in order, so once it's acked a lost write has already been NAKed and this call would have resent it
+	if (bWroteSomething)
+	{
+		ChannelInfo->UnackedPacketId = Channel->Connection->OutPacketId + 1;
+	}
+	else if (ChannelInfo->UnackedPacketId != INDEX_NONE && Channel->Connection->OutAckPacketId >= ChannelInfo->UnackedPacketId)
+	{
+		ChannelInfo->UnackedPacketId = INDEX_NONE;
+	}
+
+	return bWroteSomething;
+}
+
+bool UAEStateManager::IsSupportedForNetworking() const
+{
+	return bReplicateStates;
+}
+
+void UAEStateManager::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UAEStateManager, NetState);
+	DOREPLIFETIME_CONDITION(UAEStateManager, AcknowledgedPredictionKey, COND_OwnerOnly);
+}
+
+int32 UAEStateManager::GetFunctionCallspace(UFunction * Function, void * Parameters, FFrame * Stack)
+{
+	AActor * Owner = GetOuterAActor();
+
+	return Owner
+		? Owner->GetFunctionCallspace(Function, Parameters, Stack)
+		: FunctionCallspace::Local;
+}
+
+bool UAEStateManager::CallRemoteFunction(UFunction * Function, void * Parameters, FOutParmRec * OutParms, FFrame * Stack)
+{
+	AActor * Owner = GetOuterAActor();
+	UNetDriver * NetDriver = Owner ? Owner->GetNetDriver() : NULL;
+
+	if (NetDriver)
+	{
+		NetDriver->ProcessRemoteFunction(Owner, Function, Parameters, OutParms, Stack, this);
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,128 @@
+#include "AEStateProfiler.h"
+
+#include "EngineUtils.h"
+
+#include "AEState.h"
+#include "AEStateManager.h"
+
+#if AE_STATE_PROFILING
+
+int32 FAEStateProfiler::bEnabled = 0;
+
+TArray<FAEStateClassProfile> FAEStateProfiler::Profiles;
+
+static FAutoConsoleVariableRef CVarAEStateProfiling(
+	TEXT("ae.StateProfiling"),
+	FAEStateProfiler::bEnabled,
+	TEXT("1 to record the time spent in each UAEState class.  See AE.DumpStateProfile."),
+	ECVF_Cheat);
+
+void FAEStateProfiler::Record(UClass * StateClass, AEStateProfileStat::Type Stat, uint64 Cycles, uint32 Calls)
+{
+	check(IsInGameThread());
+
+	const int32 ClassId = UAEState::GetStateClassId(StateClass);
+
+	if (ClassId == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (ClassId >= Profiles.Num())
+	{
+		Profiles.SetNum(ClassId + 1);
+	}
+
+	FAEStateClassProfile& Profile = Profiles[ClassId];
+	Profile.StateClass = StateClass;
+	Profile.Cycles[Stat] += Cycles;
+	Profile.Calls[Stat] += Calls;
+}
+
+void FAEStateProfiler::Reset()
+{
+	Profiles.Reset();
+}
+
+const TArray<FAEStateClassProfile>& FAEStateProfiler::GetProfiles()
+{
+	return Profiles;
+}
+
+static void DumpStateProfile(const TArray<FString>& Args, UWorld * World, FOutputDevice& Ar)
+{
+	const int32 NumToShow = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10;
+
+	if (!FAEStateProfiler::bEnabled)
+	{
+		Ar.Logf(TEXT("ae.StateProfiling is off, set it to 1 to record state times."));
+	}
+
+	TArray<const FAEStateClassProfile *> SortedProfiles;
+
+	for (const FAEStateClassProfile& Profile : FAEStateProfiler::GetProfiles())
+	{
+		if (Profile.StateClass.IsValid())
+		{
+			SortedProfiles.Add(&Profile);
+		}
+	}
+
+	SortedProfiles.Sort([](const FAEStateClassProfile& A, const FAEStateClassProfile& B)
+	{
+		return A.GetTotalCycles() > B.GetTotalCycles();
+	});
+
+	static const TCHAR * StatNames[AEStateProfileStat::MAX] = { TEXT("Tick"), TEXT("Begin"), TEXT("End"), TEXT("Interrupt") };
+
+	Ar.Logf(TEXT("Top %d state classes by total time:"), NumToShow);
+
+	for (int32 ProfileInd = 0; ProfileInd < FMath::Min(NumToShow, SortedProfiles.Num()); ++ProfileInd)
+	{
+		const FAEStateClassProfile& Profile = *SortedProfiles[ProfileInd];
+
+		FString Line = FString::Printf(TEXT("  %-40s %8.3f ms"), *Profile.StateClass->GetName(), FPlatformTime::ToMilliseconds64(Profile.GetTotalCycles()));
+
+		for (int32 Stat = 0; Stat < AEStateProfileStat::MAX; ++Stat)
+		{
+			Line += FString::Printf(TEXT("  %s %.3f ms/%u"), StatNames[Stat], FPlatformTime::ToMilliseconds64(Profile.Cycles[Stat]), Profile.Calls[Stat]);
+		}
+
+		Ar.Logf(TEXT("%s"), *Line);
+	}
+
+	//transition counts are always tracked per manager
+	TArray<UAEStateManager *> Managers;
+
+	for (TObjectIterator<UAEStateManager> It; It; ++It)
+	{
+		if (!It->IsTemplate() && It->GetWorld() == World && It->GetTransitionCount() > 0)
+		{
+			Managers.Add(*It);
+		}
+	}
+
+	Managers.Sort([](const UAEStateManager& A, const UAEStateManager& B)
+	{
+		return A.GetTransitionCount() > B.GetTransitionCount();
+	});
+
+	Ar.Logf(TEXT("Top %d state managers by transitions:"), NumToShow);
+
+	for (int32 ManagerInd = 0; ManagerInd < FMath::Min(NumToShow, Managers.Num()); ++ManagerInd)
+	{
+		Ar.Logf(TEXT("  %-60s %u"), *Managers[ManagerInd]->GetPathName(World), Managers[ManagerInd]->GetTransitionCount());
+	}
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice DumpStateProfileCommand(
+	TEXT("AE.DumpStateProfile"),
+	TEXT("Prints the N (default 10) most expensive UAEState classes and the state managers in the world with the most transitions."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&DumpStateProfile));
+
+static FAutoConsoleCommand ResetStateProfileCommand(
+	TEXT("AE.ResetStateProfile"),
+	TEXT("Clears the recorded UAEState times."),
+	FConsoleCommandDelegate::CreateStatic(&FAEStateProfiler::Reset));
+
+#endif // AE_STATE_PROFILING
@@ -0,0 +1,223 @@
+#include "AEStateTickManager.h"
+
+#include "Async/ParallelFor.h"
+
+#include "AEState.h"
+#include "AEStateManager.h"
+#include "AEStateProfiler.h"
+
+TArray<AAEStateTickManager *> AAEStateTickManager::Instances;
+
+AAEStateTickManager::AAEStateTickManager(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bReplicates = false;
+	bHidden = true;
+}
+
+void AAEStateTickManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	Instances.Add(this);
+}
+
+void AAEStateTickManager::BeginDestroy()
+{
+	//destroyed without ever getting EndPlay
+	Instances.RemoveSwap(this);
+
+	Super::BeginDestroy();
+}
+
+void AAEStateTickManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Instances.RemoveSwap(this);
+
+	for (const TWeakObjectPtr<UAEStateManager>& StateManager : StateManagers)
+	{
+		if (StateManager.IsValid())
+		{
+			StateManager->bRegisteredWithTickManager = false;
+		}
+	}
+
+	StateManagers.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AAEStateTickManager * AAEStateTickManager::Get(UWorld * World)
+{
+	if (!World)
+	{
+		return NULL;
+	}
+
+	for (AAEStateTickManager * Instance : Instances)
+	{
+		if (Instance->GetWorld() == World && !Instance->IsPendingKill())
+		{
+			return Instance;
+		}
+	}
+
+	//don't spawn into editor worlds or worlds that are being torn down, unregistering during teardown finds the existing instance above
+	if (!World->IsGameWorld() || World->bIsTearingDown)
+	{
+		return NULL;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<AAEStateTickManager>(SpawnParams);
+}
+
+void AAEStateTickManager::RegisterStateManager(UAEStateManager * StateManager)
+{
+	if (StateManager && !StateManager->bRegisteredWithTickManager)
+	{
+		StateManager->bRegisteredWithTickManager = true;
+		StateManagers.Add(StateManager);
+	}
+}
+
+void AAEStateTickManager::UnregisterStateManager(UAEStateManager * StateManager)
+{
+	if (StateManager && StateManager->bRegisteredWithTickManager)
+	{
+		StateManager->bRegisteredWithTickManager = false;
+		StateManagers.RemoveSwap(StateManager);
+	}
+}
+
+void AAEStateTickManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	//drop buckets of classes that haven't ticked in a while so replaced Blueprint classes don't pile up
+	bool bRemovedBucket = false;
+
+	for (int32 BucketInd = TickBuckets.Num() - 1; BucketInd >= 0; --BucketInd)
+	{
+		FAEStateTickBucket& Bucket = TickBuckets[BucketInd];
+
+		if (Bucket.States.Num() > 0)
+		{
+			Bucket.NumIdleTicks = 0;
+		}
+		else if (++Bucket.NumIdleTicks > MAX_IDLE_BUCKET_TICKS)
+		{
+			TickBuckets.RemoveAtSwap(BucketInd, 1, false);
+			bRemovedBucket = true;
+			continue;
+		}
+
+		Bucket.States.Reset();
+		Bucket.DeltaTimes.Reset();
+	}
+
+	if (bRemovedBucket)
+	{
+		TickBucketIndexForClass.Reset();
+
+		for (int32 BucketInd = 0; BucketInd < TickBuckets.Num(); ++BucketInd)
+		{
+			TickBucketIndexForClass.Add(TickBuckets[BucketInd].StateClass, BucketInd);
+		}
+	}
+
+	//gather the active states and prune managers that went away
+	for (int32 ManagerInd = StateManagers.Num() - 1; ManagerInd >= 0; --ManagerInd)
+	{
+		UAEStateManager * StateManager = StateManagers[ManagerInd].Get();
+
+		if (!StateManager || StateManager->GetOuterAActor()->IsPendingKill())
+		{
+			StateManagers.RemoveAtSwap(ManagerInd, 1, false);
+			continue;
+		}
+
+		UAEState * State = StateManager->GetCurrentState();
+		float StateDeltaTime;
+
+		if (State && State->GetIsActive() && State->ShouldTick(DeltaTime, StateDeltaTime))
+		{
+			UClass * StateClass = State->GetClass();
+			int32 * BucketInd = TickBucketIndexForClass.Find(StateClass);
+
+			if (!BucketInd)
+			{
+				BucketInd = &TickBucketIndexForClass.Add(StateClass, TickBuckets.AddDefaulted());
+
+				FAEStateTickBucket& Bucket = TickBuckets[*BucketInd];
+				Bucket.StateClass = StateClass;
+				Bucket.NumIdleTicks = 0;
+
+				//a Blueprint override lives in the Blueprint class and can only be called through ProcessEvent, which isn't thread safe
+				UFunction * TickFunction = StateClass->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(UAEState, Tick));
+				Bucket.bCanTickInParallel = StateClass->GetDefaultObject<UAEState>()->bTickIsThreadSafe
+					&& TickFunction && TickFunction->GetOuter() == UAEState::StaticClass();
+			}
+
+			TickBuckets[*BucketInd].States.Add(State);
+			TickBuckets[*BucketInd].DeltaTimes.Add(StateDeltaTime);
+		}
+	}
+
+	for (FAEStateTickBucket& Bucket : TickBuckets)
+	{
+		if (Bucket.States.Num() == 0)
+		{
+			continue;
+		}
+
+		AE_STATE_PROFILE_SCOPE_CALLS(Bucket.StateClass, TICK, Bucket.States.Num());
+
+		if (bAllowParallelTick && Bucket.States.Num() > 1 && Bucket.bCanTickInParallel)
+		{
+			//thread safe ticks can't transition, but the same checks as the serial path keep them consistent
+			ParallelFor(Bucket.States.Num(), [&Bucket](int32 StateInd)
+			{
+				UAEState * State = Bucket.States[StateInd];
+
+				if (State->GetIsActive())
+				{
+					State->Tick_Implementation(Bucket.DeltaTimes[StateInd]);
+				}
+			});
+		}
+		else
+		{
+			for (int32 StateInd = 0; StateInd < Bucket.States.Num(); ++StateInd)
+			{
+				//an earlier state may have transitioned this one's manager this frame
+				if (Bucket.States[StateInd]->GetIsActive())
+				{
+					Bucket.States[StateInd]->Tick(Bucket.DeltaTimes[StateInd]);
+				}
+			}
+		}
+	}
+
+	//deferred transitions are applied once all states have ticked.
+	//OnBegin can spawn or destroy actors whose managers register or unregister, so go through a copy
+	PendingTransitionManagers.Reset();
+	PendingTransitionManagers.Append(StateManagers);
+
+	for (int32 ManagerInd = 0; ManagerInd < PendingTransitionManagers.Num(); ++ManagerInd)
+	{
+		UAEStateManager * StateManager = PendingTransitionManagers[ManagerInd].Get();
+
+		if (StateManager && StateManager->bHasPendingTransition)
+		{
+			StateManager->ApplyPendingTransition();
+		}
+	}
+}
@@ -6,6 +6,8 @@
 #include "AI/Navigation/NavigationSystem.h"
 #include "Camera/CameraAnim.h"
 
+#include "AEComponentTraversal.h"
+
 #include "AEGameplayStatics.generated.h"
 
 UENUM(BlueprintType)
@@ -144,9 +146,106 @@ struct AEFRAMEWORK_API FAnimationList
     TArray<UAnimMontage *> AnimationList;
 };
 
-AEFRAMEWORK_API void AttachedActorsHelper(AActor * Actor, USceneComponent * Component, std::function<bool(AActor *)> Func);
+/**
+One attachment for UAEGameplayStatics::AttachComponentsToComponent, the fields match the parameters of UAEGameplayStatics::AttachComponentToComponent.
+*/
+USTRUCT(BlueprintType)
+struct AEFRAMEWORK_API FAEAttachRequest
+{
+	GENERATED_BODY()
+
+	FAEAttachRequest()
+		: Child(NULL),
+		Parent(NULL),
+		ParentSocketName(NAME_None),
+		ChildSocketName(NAME_None),
+		ParentSocketSceneComponent(NULL),
+		ChildSocketSceneComponent(NULL),
+		bWeldSimulatedBodies(true)
+	{}
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Utility")
+	USceneComponent * Child;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Utility")
+	USceneComponent * Parent;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Utility")
+	FName ParentSocketName;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Utility")
+	FName ChildSocketName;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Utility")
+	USceneComponent * ParentSocketSceneComponent;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Utility")
+	USceneComponent * ChildSocketSceneComponent;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Utility")
+	bool bWeldSimulatedBodies;
+};
+
+/**
+Helper for traversing attached actors heirarchy and calls a lambda on them.
+Have the lambda return false to stop traversal below that actor.
+
+Walks depth first with an explicit stack instead of recursing, and calls the lambda directly, 
+so it doesn't copy the lambda per component or touch the heap for typical heirarchies.
+*/
+template<typename TFunc>
+FORCEINLINE_DEBUGGABLE void AttachedActorsHelper(AActor * Actor, USceneComponent * Component, TFunc&& Func)
+{
+	struct FPendingComponent
+	{
+		AActor * Actor;
+		USceneComponent * Component;
+	};
+
+	TArray<FPendingComponent, TInlineAllocator<AE_COMPONENT_TRAVERSAL_INLINE_SIZE>> Pending;
+	Pending.Add({ Actor, Component });
+
+	while (Pending.Num() > 0)
+	{
+		const FPendingComponent Curr = Pending.Pop(false);
+
+		if (!Curr.Component)
+		{
+			continue;
+		}
 
-AEFRAMEWORK_API void LevelComponentsTraverser(USceneComponent * Component, std::function<bool(USceneComponent *)> Func);
+		AActor * ComponentOwner = Curr.Component->GetOwner();
+
+		if (ComponentOwner != Curr.Actor)
+		{
+			//reached the root of an attached actor, continue into its heirarchy if the lambda allows it
+			if (Func(ComponentOwner))
+			{
+				Pending.Add({ ComponentOwner, Curr.Component });
+			}
+
+			continue;
+		}
+
+		//pushed in reverse so children are visited in order
+		const TArray<USceneComponent *>& Children = Curr.Component->GetAttachChildren();
+
+		for (int32 ChildInd = Children.Num() - 1; ChildInd >= 0; --ChildInd)
+		{
+			Pending.Add({ Curr.Actor, Children[ChildInd] });
+		}
+	}
+}
+
+/**
+Level order traversal of the component heirarchy under Component, see TraverseComponents.
+Have the lambda return true to stop traversal.
+*/
+template<typename TFunc>
+FORCEINLINE_DEBUGGABLE void LevelComponentsTraverser(USceneComponent * Component, TFunc&& Func)
+{
+	TraverseComponents<AEComponentTraversalOrder::BREADTH_FIRST>(Component, Forward<TFunc>(Func));
+}
 
 UCLASS(CustomConstructor)
 class AEFRAMEWORK_API UAEGameplayStatics : public UBlueprintFunctionLibrary
@@ -180,9 +279,17 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Utility")
     static void DestroyAttachedActors(AActor * Actor);
 
+	/**
+	Like DestroyAttachedActors, but the attached actors are hidden and have their collision disabled right away
+	and are destroyed over the next frames by AAEActorDestructionQueue.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Utility")
+	static void DestroyAttachedActorsDeferred(AActor * Actor);
+
     /**
     Goes through component heirarchy of an actor and sets visibility on all actors
     that are attached to any components of said actor.
+    Applied at the end of the frame through AAEActorStateBatcher.
     */
     UFUNCTION(BlueprintCallable, Category = "Utility")
     static void SetAttachedActorsHiddenInGame(AActor * Actor, bool bVisible);
@@ -190,6 +297,7 @@ public:
 	/**
 	Goes through component heirarchy of an actor and sets collision enabled on all actors
 	that are attached to any components of said actor.
+	Applied at the end of the frame through AAEActorStateBatcher.
 	*/
 	UFUNCTION(BlueprintCallable, Category = "Utility")
     static void SetAttachedActorsEnableCollision(AActor * Actor, bool bEnabled);
@@ -209,6 +317,10 @@ public:
 	
 	/**
 	Goes through the component heirarchy from RootComponent and finds the first component that has the named socket name in the heirarchy.
+
+	On the game thread, the sockets of the whole heirarchy under RootComponent are indexed the first time so later calls are a map lookup.
+	After AAEPhysicalActor::NotifyAttachmentChanged the index is only rebuilt if the attach child counts under RootComponent changed.
+	It's also rebuilt when a lookup finds that a component lost its socket or was detached from RootComponent, or that a socket appeared that isn't indexed yet.
 	*/
 	UFUNCTION(BlueprintPure, Category = "Utility")
 	static USceneComponent * FindAttachedComponentWithSocket(USceneComponent * RootComponent, FName Socket);
@@ -218,6 +330,10 @@ public:
 	If SocketSceneComponent is passed in, the Socket is expected to already be on that scene component and RootComponent and SocketSceneComponent are expected to be in the same actor.
 	If SocketSceneComponent is NULL, it automatically finds the scene component attached to RootComponent that has that socket name using FindAttachedComponentWithSocket.
 	If Socket is blank it just returns the relative transform between RootComponent and SocketSceneComponent.
+
+	Results are cached on the game thread while the components between RootComponent and SocketSceneComponent don't move relative to each other.
+	Animated sockets and links, like skeletal mesh sockets and bones, and links with absolute location, rotation or scale are never cached.
+	Links that are reattached and static mesh socket components whose mesh is swapped are noticed per entry, so attaching other components doesn't clear the cache.
 	*/
 	UFUNCTION(BlueprintPure, Category = "Utility")
 	static FTransform GetRelativeTransformToSocket(USceneComponent * RootComponent, FName Socket, USceneComponent * SocketSceneComponent = NULL);
@@ -282,6 +398,18 @@ public:
 		USceneComponent * ParentSocketSceneComponent = NULL,
 		USceneComponent * ChildSocketSceneComponent = NULL,
 		bool bWeldSimulatedBodies = true);
+
+	/**
+	Same as calling AttachComponentToComponent for each request, but cheaper when attaching lots of components at once, like props to a rig.
+	Sockets and offsets are resolved before the children are attached, each child gets one transform update with its final relative transform,
+	and simulated bodies are welded after everything is attached.
+	Requests whose sockets or offsets depend on an earlier request in the batch, like one attaching to a socket on a scope the batch also attaches,
+	get the earlier requests attached first so they resolve the same as they would one at a time.
+	*/
+	static void AttachComponentsToComponent(TArrayView<const FAEAttachRequest> Requests);
+
+	UFUNCTION(BlueprintCallable, Category = "Utility", meta = (DisplayName = "Attach Components To Component"))
+	static void K2_AttachComponentsToComponent(const TArray<FAEAttachRequest>& Requests);
 	
 	/**
 	Gets relative transform between root component of actor and another component.
@@ -457,6 +585,11 @@ FORCEINLINE_DEBUGGABLE bool UAEGameplayStatics::GetOverrideBoolValue(bool bCurre
 	return ::GetOverrideBoolValue(bCurrentValue, OverrideValue);
 }
 
+FORCEINLINE_DEBUGGABLE void UAEGameplayStatics::K2_AttachComponentsToComponent(const TArray<FAEAttachRequest>& Requests)
+{
+	AttachComponentsToComponent(Requests);
+}
+
 FORCEINLINE_DEBUGGABLE void UAEGameplayStatics::SeamlessTravel(UWorld * World, const FString& URL)
 {
 	World->SeamlessTravel(URL);
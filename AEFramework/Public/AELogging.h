@@ -4,8 +4,68 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(AE, Log, All);
 
-#define UE_LOG_ON_SCREEN(CategoryName, Verbosity, TimeToDisplay, DisplayColor, Format, ...) \
+/**
+AE_LOGGING compiles AE_LOG_ON_SCREEN out entirely, arguments included.  It follows NO_LOGGING by default.
+AE_ON_SCREEN_LOGGING compiles out just the on screen part, it's off in shipping and on dedicated server builds.
+*/
+#ifndef AE_LOGGING
+#define AE_LOGGING !NO_LOGGING
+#endif
+
+#ifndef AE_ON_SCREEN_LOGGING
+#define AE_ON_SCREEN_LOGGING (AE_LOGGING && !UE_BUILD_SHIPPING && !UE_SERVER)
+#endif
+
+#if AE_LOGGING
+
+/**
+Per call site state for AE_LOG_ON_SCREEN, one is declared static at each use of the macro.
+*/
+struct FAELogCallSite
+{
+	double LastLogTime;
+
+	int32 SuppressedCount;
+};
+
+struct AEFRAMEWORK_API FAELog
+{
+	/**
+	Returns true if the call site hasn't logged within ae.LogRepeatInterval seconds, otherwise counts the message as suppressed.
+	OutSuppressedCount is how many messages were suppressed since the call site last logged.
+	*/
+	static bool ShouldLog(FAELogCallSite& CallSite, int32& OutSuppressedCount);
+
+	/**
+	Logs an already formatted message and queues it to show on screen.
+	On screen messages are batched and shown at the end of the frame, one line per call site.
+	*/
+	static void Log(const FAELogCallSite& CallSite, const ANSICHAR * File, int32 Line, const FLogCategoryBase& Category, ELogVerbosity::Type Verbosity,
+		float TimeToDisplay, FColor DisplayColor, int32 SuppressedCount, const FString& Message);
+};
+
+/**
+Logs to a category and also shows the message on screen.
+The message is formatted once and only if the category isn't suppressed.
+Repeats from the same call site within ae.LogRepeatInterval seconds are counted and reported with the next message instead of being logged.
+*/
+#define AE_LOG_ON_SCREEN(CategoryName, Verbosity, TimeToDisplay, DisplayColor, Format, ...) \
 { \
-	UE_LOG(CategoryName, Verbosity, Format, ##__VA_ARGS__); \
-	GEngine->AddOnScreenDebugMessage(-1, TimeToDisplay, DisplayColor, FString::Printf(Format, ##__VA_ARGS__)); \
-}
\ No newline at end of file
+	static FAELogCallSite AELogCallSite = { TNumericLimits<double>::Lowest(), 0 }; \
+	int32 AELogSuppressedCount = 0; \
+	if (!CategoryName.IsSuppressed(ELogVerbosity::Verbosity) && FAELog::ShouldLog(AELogCallSite, AELogSuppressedCount)) \
+	{ \
+		FAELog::Log(AELogCallSite, __FILE__, __LINE__, CategoryName, ELogVerbosity::Verbosity, TimeToDisplay, DisplayColor, AELogSuppressedCount, FString::Printf(Format, ##__VA_ARGS__)); \
+	} \
+}
+
+#else
+
+#define AE_LOG_ON_SCREEN(CategoryName, Verbosity, TimeToDisplay, DisplayColor, Format, ...) {}
+
+#endif // AE_LOGGING
+
+/**
+Kept for existing game code, same as AE_LOG_ON_SCREEN.
+*/
+#define UE_LOG_ON_SCREEN AE_LOG_ON_SCREEN
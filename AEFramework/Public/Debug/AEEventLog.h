@@ -0,0 +1,140 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+Compiles AE_RECORD_EVENT out entirely when 0.  Off in Shipping by default.
+*/
+#ifndef AE_EVENT_LOG
+#define AE_EVENT_LOG !UE_BUILD_SHIPPING
+#endif
+
+namespace AEEventType
+{
+	enum Type
+	{
+		/** Names: state manager owner, previous state class, new state class */
+		STATE_TRANSITION,
+		/** Names: mesh owner, notification name, animation */
+		NAMED_NOTIFY,
+		/** Names: attachment component owner, attached actor, socket */
+		ATTACHMENT_SPAWN,
+		/** Names: attachment component owner, attached actor, socket */
+		ATTACHMENT_DISCONNECT,
+		/** Names: spawning actor, spawning collision.  Values: requested location, adjusted location */
+		SAFE_SPAWN_ADJUST,
+
+		MAX
+	};
+}
+
+/**
+An FName stored by index so recording an event doesn't touch the name table.
+The plain strings are written when the log is flushed and the number is appended when it's decoded.
+*/
+struct FAEEventName
+{
+	int32 Index;
+	int32 Number;
+
+	FORCEINLINE static FAEEventName Make(FName Name)
+	{
+		FAEEventName Res;
+		Res.Index = Name.GetComparisonIndex();
+		Res.Number = Name.GetNumber();
+		return Res;
+	}
+};
+
+/**
+Fixed size record, written to the event log file as is.
+*/
+struct FAEEventRecord
+{
+	/** FPlatformTime::Cycles64 when the event was recorded */
+	uint64 Cycles;
+
+	uint32 ThreadId;
+
+	/** AEEventType::Type */
+	uint8 Type;
+
+	uint8 Padding[3];
+
+	FAEEventName Names[3];
+
+	float Values[6];
+};
+
+static_assert(sizeof(FAEEventRecord) == 64, "FAEEventRecord is expected to be 64 bytes.");
+
+/**
+Binary record of framework level events for looking into hitches after the fact, like which states a server was transitioning through.
+
+Every thread that records an event gets its own ring buffer of the last RECORDS_PER_THREAD events, so recording is a handful of stores with no locking or formatting.
+The buffers are written to a file with the AE.FlushEventLog console command, by calling Flush, or when the engine handles a crash.
+Records are written in buffer order and sorted by the decoder, so flushing doesn't allocate anything beyond the file handle.
+For crashes that file handle is opened up front, Saved/Logs/AEEventLog-Crash-<pid>-<timestamp>.aeev, and deleted again on a clean exit.
+Empty crash files of processes that are no longer running are deleted when the next run opens its own.
+Use the AEEventLogDecode commandlet in AEFrameworkEditor to turn the file into CSV.
+
+Recording can be turned off at runtime with ae.EventLog 0, or compiled out with AE_EVENT_LOG along with its console commands.
+Decoding is always available.
+*/
+class AEFRAMEWORK_API FAEEventLog
+{
+public:
+	const static int32 RECORDS_PER_THREAD = 4096;
+
+	const static uint32 FILE_MAGIC = 0x56454541;	// "AEEV"
+
+	const static uint32 FILE_VERSION = 2;
+
+#if AE_EVENT_LOG
+	/**
+	Value of the ae.EventLog console variable.
+	*/
+	static int32 bEnabled;
+
+	static void Record(AEEventType::Type Type, FName Name0, FName Name1 = NAME_None, FName Name2 = NAME_None,
+		const FVector& Value0 = FVector::ZeroVector, const FVector& Value1 = FVector::ZeroVector);
+
+	/**
+	Writes every thread's buffer to Filename.
+	A thread recording while this runs can overwrite its oldest events mid write, so the first few events of a busy thread may be garbage.
+
+	@return false if the file couldn't be written
+	*/
+	static bool Flush(const FString& Filename);
+
+	/**
+	Saved/Logs/AEEventLog-<timestamp>.aeev
+	*/
+	static FString GetDefaultFilename();
+#endif // AE_EVENT_LOG
+
+	/**
+	Turns the contents of a flushed file into CSV with one line per event.
+
+	@return false if the data isn't an event log this version can read
+	*/
+	static bool DecodeToCsv(const TArray<uint8>& FileData, FString& OutCsv);
+
+	static const TCHAR * GetEventTypeName(uint8 Type);
+};
+
+#if AE_EVENT_LOG
+
+#define AE_RECORD_EVENT(Type, ...) \
+{ \
+	if (FAEEventLog::bEnabled) \
+	{ \
+		FAEEventLog::Record(AEEventType::Type, ##__VA_ARGS__); \
+	} \
+}
+
+#else
+
+#define AE_RECORD_EVENT(Type, ...) {}
+
+#endif // AE_EVENT_LOG
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "AEActorDestructionQueue.generated.h"
+
+struct FAEQueuedDestruction
+{
+	TWeakObjectPtr<AActor> Actor;
+
+	/**
+	How many actors up the attach heirarchy the actor was when queued, 0 for the actor the heirarchy was queued from.
+	*/
+	int32 Depth;
+};
+
+/**
+One per world.  Destroys actor heirarchies a few actors at a time so cleaning up something with lots of attached actors,
+like a vehicle full of props or a corpse with all its gear, doesn't spike the frame.
+
+Queued heirarchies are hidden and have collision disabled right away, then destroyed deepest attached actors first
+within a per frame budget set by ae.DestructionQueueBudgetMs.  At least one actor is destroyed each frame while the queue isn't empty.
+The queue depth shows up under stat AEFramework.
+*/
+UCLASS(NotPlaceable, Transient)
+class AEFRAMEWORK_API AAEActorDestructionQueue : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AAEActorDestructionQueue(const FObjectInitializer& ObjectInitializer);
+
+	virtual void PostInitializeComponents() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void BeginDestroy() override;
+	virtual void Tick(float DeltaTime) override;
+
+	/**
+	Gets the destruction queue for a world, spawning it if it doesn't exist yet.
+	*/
+	static AAEActorDestructionQueue * Get(UWorld * World);
+
+	/**
+	Queues every actor attached anywhere in RootActor's component heirarchy, and RootActor itself if bIncludeRootActor is set.
+	Attached actors are destroyed directly, the same as AAEPhysicalActor::DestroyActorHeirarchy does.
+	RootActor is destroyed last through DestroyActorHeirarchy if it's an AAEPhysicalActor, so overrides of it still run.
+	Pooled actors are released to AAEActorPool right away instead of being queued, and the actors attached to them stay with them.
+	*/
+	void Enqueue(AActor * RootActor, bool bIncludeRootActor);
+
+	/**
+	Number of actors waiting to be destroyed.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Utilities")
+	int32 GetQueueDepth() const;
+
+protected:
+	/**
+	Actors before QueueHead have already been destroyed, the array is compacted once most of it is behind the head.
+	*/
+	TArray<FAEQueuedDestruction> Queue;
+
+	int32 QueueHead;
+
+private:
+	static TArray<AAEActorDestructionQueue *> Instances;
+};
+
+FORCEINLINE_DEBUGGABLE int32 AAEActorDestructionQueue::GetQueueDepth() const
+{
+	return Queue.Num() - QueueHead;
+}
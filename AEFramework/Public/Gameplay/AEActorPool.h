@@ -0,0 +1,109 @@
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "AEActorPool.generated.h"
+
+class AAEPhysicalActor;
+class UAEStateManager;
+
+/**
+What was ticking in a pooled actor's heirarchy when it was released, so exactly that is turned back on when it's acquired.
+*/
+struct FAEPooledActorTickState
+{
+	TArray<TWeakObjectPtr<AActor>> Actors;
+
+	TArray<TWeakObjectPtr<UActorComponent>> Components;
+
+	/**
+	Managers that were registered with AAEStateTickManager.
+	*/
+	TArray<TWeakObjectPtr<UAEStateManager>> StateManagers;
+};
+
+USTRUCT()
+struct FAEActorPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AAEPhysicalActor *> Actors;
+
+	/**
+	Parallel to Actors.
+	*/
+	TArray<FAEPooledActorTickState> TickStates;
+};
+
+/**
+One per world.  Keeps released AAEPhysicalActors of classes with AAEPhysicalActor::bUseActorPool set hidden, without collision or physics,
+and hands them back out instead of spawning new ones, so things like magazines that are constantly spawned and thrown away
+don't keep paying for spawning, physics body creation, and garbage collection.
+
+Released actors keep their own attached actors, so a pooled gun comes back with its magazine.
+Actor and component ticks in the whole released heirarchy are turned off, and its state managers are unregistered from AAEStateTickManager.
+
+Acquired actors get back what was ticking and are made visible with collision enabled,
+then IAEResetInterface::Reset is called if they implement it, then AAEPhysicalActor::OnAcquiredFromPool, which reattaches the attachments.
+Only then is physics enabled on the acquired actor itself, the attachments keep whatever state their attachment components gave them.
+
+UAEPhysicalActorAttachmentComponent::SpawnAttachment and AAEPhysicalActor::DestroyActorHeirarchy use the pool for pooled classes.
+*/
+UCLASS(NotPlaceable, Transient)
+class AEFRAMEWORK_API AAEActorPool : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AAEActorPool(const FObjectInitializer& ObjectInitializer);
+
+	virtual void PostInitializeComponents() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void BeginDestroy() override;
+
+	/**
+	Gets the pool for a world, spawning it if it doesn't exist yet.
+	*/
+	static AAEActorPool * Get(UWorld * World);
+
+	/**
+	Takes an actor of Class out of the pool of World, or spawns one if the class isn't pooled or the pool is empty.
+	*/
+	static AAEPhysicalActor * SpawnOrAcquireActor(UWorld * World, TSubclassOf<AAEPhysicalActor> Class, const FTransform& Transform, AActor * Owner);
+
+	/**
+	Returns an actor to the pool of its world if its class is pooled.
+
+	@return false if the actor wasn't pooled, it's up to the caller to destroy it then
+	*/
+	static bool ReleaseActor(AAEPhysicalActor * Actor);
+
+	/**
+	Takes an actor of Class out of the pool, or spawns one if the pool is empty.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Pooling")
+	AAEPhysicalActor * AcquireActor(TSubclassOf<AAEPhysicalActor> Class, const FTransform& Transform, AActor * Owner);
+
+	/**
+	Hides the actor, disables its collision, physics, and ticking across its heirarchy, and keeps it for later.
+	If the pool already holds ae.ActorPoolMaxPerClass actors of the class, the actor is destroyed instead.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Pooling")
+	void Release(AAEPhysicalActor * Actor);
+
+	/**
+	Spawns actors into the pool until it holds at least Count actors of Class.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Pooling")
+	void Prewarm(TSubclassOf<AAEPhysicalActor> Class, int32 Count);
+
+	UFUNCTION(BlueprintCallable, Category = "Pooling")
+	int32 GetNumPooledActors(TSubclassOf<AAEPhysicalActor> Class) const;
+
+protected:
+	UPROPERTY(Transient)
+	TMap<UClass *, FAEActorPoolBucket> Buckets;
+
+private:
+	static TArray<AAEActorPool *> Instances;
+};
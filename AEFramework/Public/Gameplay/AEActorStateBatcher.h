@@ -0,0 +1,73 @@
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "AEActorStateBatcher.generated.h"
+
+/**
+The last hidden and collision state requested for an actor this frame.
+*/
+struct FAEPendingActorState
+{
+	TWeakObjectPtr<AActor> Actor;
+
+	uint8 bHasHidden:1;
+	uint8 bHidden:1;
+
+	uint8 bHasCollision:1;
+	uint8 bCollisionEnabled:1;
+};
+
+/**
+One per world.  Defers SetActorHiddenInGame and SetActorEnableCollision calls made on actor heirarchies
+so that an actor toggled several times in a frame only has its render state and physics filtering updated once, with the final value.
+Requests that end up matching the actor's current state are skipped entirely.
+
+The SetAttachedActors and SetActorHeirarchy functions of UAEGameplayStatics and AAEPhysicalActor go through here.
+Pending states are applied after all other actors tick, or right away with Flush.
+Set ae.DeferHeirarchyStateUpdates to 0 to apply every request immediately, no-op requests are still skipped.
+*/
+UCLASS(NotPlaceable, Transient)
+class AEFRAMEWORK_API AAEActorStateBatcher : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AAEActorStateBatcher(const FObjectInitializer& ObjectInitializer);
+
+	virtual void PostInitializeComponents() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void BeginDestroy() override;
+	virtual void Tick(float DeltaTime) override;
+
+	/**
+	Gets the batcher for a world, spawning it if it doesn't exist yet.
+	Returns NULL for worlds that aren't game worlds.
+	*/
+	static AAEActorStateBatcher * Get(UWorld * World);
+
+	/**
+	Sets an actor hidden or not by the end of the frame.
+	*/
+	static void RequestActorHiddenInGame(AActor * Actor, bool bNewHidden);
+
+	/**
+	Enables or disables an actor's collision by the end of the frame.
+	*/
+	static void RequestActorEnableCollision(AActor * Actor, bool bNewCollision);
+
+	/**
+	Applies every pending state now.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Utilities")
+	void Flush();
+
+protected:
+	FAEPendingActorState& AddPendingState(AActor * Actor);
+
+	TArray<FAEPendingActorState> PendingStates;
+
+	TMap<TWeakObjectPtr<AActor>, int32> PendingStateIndices;
+
+private:
+	static TArray<AAEActorStateBatcher *> Instances;
+};
@@ -2,6 +2,32 @@
 
 #include "AEPhysicalActor.generated.h"
 
+class AAEPhysicalActor;
+class UAEStateManager;
+
+/**
+One actor in the flattened attached actor heirarchy of an AAEPhysicalActor.
+*/
+USTRUCT()
+struct FAEAttachedActorCacheEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AActor * Actor;
+
+	/**
+	Actor cast to AAEPhysicalActor once when the cache is built, NULL if it isn't one.
+	*/
+	UPROPERTY()
+	AAEPhysicalActor * PhysicalActor;
+
+	/**
+	1 for actors attached directly to the owning actor's heirarchy, 2 for actors attached to those, and so on.
+	*/
+	int32 Depth;
+};
+
 UCLASS(Blueprintable, Abstract)
 class AEFRAMEWORK_API AAEPhysicalActor : public AActor
 {
@@ -12,17 +38,149 @@ public:
 
 	virtual void PostInitializeComponents() override;
 
+	/**
+	Replicates the UAEStateManager subobjects with bReplicateStates that existed in PostInitializeComponents.
+	*/
+	virtual bool ReplicateSubobjects(class UActorChannel * Channel, class FOutBunch * Bunch, FReplicationFlags * RepFlags) override;
+
+#if WITH_EDITOR
+	/**
+	Also validates the UAEStateManager subobjects of this actor, the engine only validates components.
+	*/
+	virtual EDataValidationResult IsDataValid(TArray<FText>& ValidationErrors) override;
+#endif // WITH_EDITOR
+
 	/**
 	All components are walked in level order of child heirarchy in PostInitializeComponents.
 	Use this to initialize useful things like finding the rootmost component of some time.
+
+	If bCacheComponentLayout is turned on, this is only called for the first actor of a class to spawn,
+	later actors of the class get PhysicsComponents and SkeletalMesh from a per class cache.
+	Overriding this in Blueprint turns the cache off automatically, don't turn on bCacheComponentLayout when overriding it in C++.
 	*/
 	UFUNCTION(BlueprintNativeEvent, Category = "Utilities")
 	void LevelOrderComponentTraverse(USceneComponent * Component);
 
+	/**
+	Whether PostInitializeComponents can reuse the components the first actor of this class found, by name, instead of walking the heirarchy.
+	Off by default.  Only turn it on for classes that don't override LevelOrderComponentTraverse in C++ and whose actors all have the same components.
+	Actors with a different number of components, or whose cached physics components don't simulate, still walk the heirarchy,
+	but a component that simulates only on some actors isn't detected.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "Utilities")
+	uint32 bCacheComponentLayout:1;
+
+protected:
+	/**
+	Finds PhysicsComponents and SkeletalMesh from the class's cached layout.
+	Returns false if there's no cached layout or some component couldn't be found, in which case nothing is set.
+	*/
+	bool ApplyCachedComponentLayout();
+
+	void CacheComponentLayout();
+
 public:
+	/**
+	Destroys the actor and the actors attached to it.
+	Actors with bUseActorPool set are released to the AAEActorPool instead, along with whatever is attached to them.
+	*/
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Utilities")
 	void DestroyActorHeirarchy();
 
+	/**
+	Hides the heirarchy and disables its collision now, then destroys it over the next frames through AAEActorDestructionQueue, deepest attached actors first.
+	Pooled actors in the heirarchy are released to AAEActorPool right away instead, along with whatever is attached to them.
+	Use this instead of DestroyActorHeirarchy for big heirarchies.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Utilities")
+	void DestroyActorHeirarchyDeferred();
+
+	/**
+	Invalidates the cached attached actor heirarchies of every AAEPhysicalActor, and the socket indices of UAEGameplayStatics::FindAttachedComponentWithSocket.
+	UAEGameplayStatics attach functions and UAEPhysicalActorAttachmentComponent already call this.
+	Call it after attaching or detaching through the engine API, like AttachToComponent or DetachFromActor, and after swapping a mesh's socket layout.
+	The attached actor caches don't check the heirarchy themselves, so until then they keep using the old heirarchy.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Utilities")
+	static void NotifyAttachmentChanged();
+
+	/**
+	Changes every time NotifyAttachmentChanged is called, never 0.  Caches of the attach heirarchy store this to know when they're stale.
+	*/
+	FORCEINLINE static uint32 GetAttachmentGeneration() { return AttachmentGeneration; }
+
+protected:
+	UPROPERTY(Transient)
+	TArray<UAEStateManager *> ReplicatedStateManagers;
+
+	/**
+	Actors attached anywhere in this actor's component heirarchy, in the same depth first order AttachedActorsHelper visits them.
+	Lets the SetActorHeirarchy functions make a linear pass instead of walking every component.
+	*/
+	UPROPERTY(Transient)
+	TArray<FAEAttachedActorCacheEntry> AttachedActorCache;
+
+	/**
+	AttachmentGeneration when AttachedActorCache was built.
+	*/
+	uint32 AttachedActorCacheGeneration;
+
+	/**
+	Root component when AttachedActorCache was built, so changing the root component rebuilds it.
+	*/
+	UPROPERTY(Transient)
+	USceneComponent * AttachedActorCacheRoot;
+
+	bool IsAttachedActorCacheValid() const;
+
+	void UpdateAttachedActorCache();
+
+	/**
+	Calls Func on each cached attached actor, rebuilding the cache first if it's stale.
+	Have Func return false to skip the actors attached below that actor.
+	*/
+	template<typename TFunc>
+	void ForEachAttachedActor(TFunc&& Func);
+
+private:
+	/**
+	Bumped by NotifyAttachmentChanged.
+	*/
+	static uint32 AttachmentGeneration;
+
+public:
+	/////////////////////////////////////// 
+	//Pooling
+
+	/**
+	Whether actors of this class are reused through AAEActorPool when spawned as attachments and when their heirarchy is destroyed.
+	Only turn this on for classes that are fully reset by OnAcquiredFromPool, or by IAEResetInterface::Reset if they implement it.
+	Released actors, the actors attached to them and their components lose their timers and latent actions, and their state managers drop pending transitions
+	and the timers and latent actions of their states, so the current state may need to be reset too.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "Pooling")
+	uint32 bUseActorPool:1;
+
+	/**
+	Called when the actor is taken back out of the pool, after its ticks are restored, it's made visible with collision enabled,
+	and IAEResetInterface::Reset is called.  Physics on the actor's own bodies is enabled after this returns.  By default resets the actor's attachment components to their default state, respawning disconnected attachments.
+	*/
+	UFUNCTION(BlueprintNativeEvent, Category = "Pooling")
+	void OnAcquiredFromPool();
+
+	/**
+	Called when the actor is released to the pool, before it's detached and hidden.
+	*/
+	UFUNCTION(BlueprintNativeEvent, Category = "Pooling")
+	void OnReleasedToPool();
+
+	FORCEINLINE bool IsInActorPool() const { return bIsInActorPool; }
+
+private:
+	uint32 bIsInActorPool:1;
+
+	friend class AAEActorPool;
+
 public:
 	/////////////////////////////////////// 
 	//Rendering
@@ -104,4 +262,35 @@ FORCEINLINE_DEBUGGABLE const TArray<UPrimitiveComponent *>& AAEPhysicalActor::Ge
 FORCEINLINE_DEBUGGABLE USkeletalMeshComponent * AAEPhysicalActor::GetSkeletalMesh() const
 {
 	return SkeletalMesh;
+}
+
+template<typename TFunc>
+FORCEINLINE_DEBUGGABLE void AAEPhysicalActor::ForEachAttachedActor(TFunc&& Func)
+{
+	if (!IsAttachedActorCacheValid())
+	{
+		UpdateAttachedActorCache();
+	}
+
+	for (int32 EntryInd = 0; EntryInd < AttachedActorCache.Num(); ++EntryInd)
+	{
+		const FAEAttachedActorCacheEntry& Entry = AttachedActorCache[EntryInd];
+
+		if (!Entry.Actor || Entry.Actor->IsPendingKill())
+		{
+			//destroyed since the cache was built, rebuild next time
+			AttachedActorCacheGeneration = AttachmentGeneration - 1;
+			continue;
+		}
+
+		if (!Func(Entry.Actor, Entry.PhysicalActor))
+		{
+			const int32 SkipDepth = Entry.Depth;
+
+			while (EntryInd + 1 < AttachedActorCache.Num() && AttachedActorCache[EntryInd + 1].Depth > SkipDepth)
+			{
+				++EntryInd;
+			}
+		}
+	}
 }
\ No newline at end of file
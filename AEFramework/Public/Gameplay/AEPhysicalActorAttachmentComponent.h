@@ -1,10 +1,16 @@
 #pragma once
 
+#include "Engine/StreamableManager.h"
+
 #include "AEPhysicalActor.h"
 #include "AEGameplayStatics.h"
 
 #include "AEPhysicalActorAttachmentComponent.generated.h"
 
+class UAEPhysicalActorAttachmentComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FAEAttachmentSpawnedSignature, UAEPhysicalActorAttachmentComponent *, AttachmentComponent, AAEPhysicalActor *, AttachedActor);
+
 /**
 Used to help manage attached PhysicalActor objects to other attached PhysicalActor objects.
 This can be useful for managing guns with attached magazines, for example.
@@ -19,6 +25,7 @@ public:
 	UAEPhysicalActorAttachmentComponent(const FObjectInitializer& ObjectInitializer);
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	UFUNCTION(BlueprintCallable, Category = "Owner")
 	AAEPhysicalActor * GetOwnerPhysicalActor() const;
@@ -27,9 +34,41 @@ public:
 	////////////////////////////////////
 	//Attachment
 
+    /**
+    Class of the attached actor.  If not set, SoftAttachedActorClass is used.
+    */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attachment")
     TSubclassOf<AAEPhysicalActor> AttachedActorClass;
 
+	/**
+	Class of the attached actor that isn't loaded with the owner, for optional attachments that may never be spawned.
+	SpawnAttachmentIfNeeded streams it in asynchronously the first time it needs it and spawns the attachment once it's loaded,
+	unless bForceSpawn is passed, in which case it's loaded right away since the caller needs the attachment now.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attachment")
+	TSoftClassPtr<AAEPhysicalActor> SoftAttachedActorClass;
+
+	/**
+	Called after the attached actor is spawned and reset to its default state, including when it's spawned after SoftAttachedActorClass finishes streaming in.
+	*/
+	UPROPERTY(BlueprintAssignable, Category = "Attachment")
+	FAEAttachmentSpawnedSignature OnAttachmentSpawned;
+
+	/**
+	AttachedActorClass, or SoftAttachedActorClass if it's loaded.  NULL if the attachment class still needs to be streamed in.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Attachment")
+	TSubclassOf<AAEPhysicalActor> GetAttachedActorClass() const;
+
+	FORCEINLINE bool HasAttachedActorClass() const { return AttachedActorClass || !SoftAttachedActorClass.IsNull(); }
+
+	/**
+	Starts streaming in SoftAttachedActorClass without spawning anything, so a later spawn doesn't have to wait.
+	Call this when the attachment is likely to be needed soon, like when a weapon with an optional attachment is picked up.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Attachment")
+	void PrefetchAttachment();
+
     /**
     Instance of the attached actor.
     */
@@ -44,6 +83,13 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attachment")
     FName AttachComponentSocket;
 
+	/**
+	If AttachedActorClass has bUseActorPool set, the AAEActorPool is filled with at least this many actors of the class on BeginPlay
+	so attachments swapped during play, like magazines, don't have to spawn.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attachment")
+	int32 PoolPrewarmCount;
+
 	/**
 	Spawns the attached actor if it doesn't exist and ShouldSpawnAttachment returns true
 	@param bForceSpawn If false, it'll only spawn the prop if it by default has physics or collision enabled
@@ -58,6 +104,14 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Attachment")
 	bool ShouldSpawnAttachment() const;
 
+	/**
+	Called by SpawnAttachmentIfNeeded() when ShouldSpawnAttachment returns false.
+	Return true if the attachment is likely to be needed soon, so SoftAttachedActorClass is streamed in ahead of time.
+	False by default so optional attachments aren't loaded until they're needed.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Attachment")
+	bool ShouldPrefetchAttachment() const;
+
 protected:
 	/**
 	Performs the actual spawning of the actor.  Don't call this directly. Call SpawnAttachmentIfNeeded.
@@ -66,6 +120,26 @@ protected:
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Attachment")
 	void SpawnAttachment();
 
+	/**
+	Streams in SoftAttachedActorClass if it's not loaded yet.
+	@param bSpawnWhenLoaded If true, SpawnAttachmentIfNeeded is called again once it's loaded
+	*/
+	void LoadAttachedActorClassAsync(bool bSpawnWhenLoaded);
+
+	void OnAttachedActorClassLoaded();
+
+	/**
+	Fills the AAEActorPool with PoolPrewarmCount actors of the attached actor class if it's pooled and loaded.
+	*/
+	void PrewarmAttachmentPool();
+
+	/**
+	Keeps SoftAttachedActorClass loaded while this component is around once it's been requested.
+	*/
+	TSharedPtr<FStreamableHandle> AttachedActorClassHandle;
+
+	uint32 bSpawnAttachmentWhenLoaded:1;
+
 public:
 	/**
     Reset the prop to default visibility and collision states
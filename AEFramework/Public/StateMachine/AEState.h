@@ -1,5 +1,7 @@
 #pragma once
 
+#include "TimerManager.h"
+#include "Engine/LatentActionManager.h"
 #include "AEState.generated.h"
 
 class UAEStateManager;
@@ -10,6 +12,8 @@ class AEFRAMEWORK_API UAEState : public UObject
 	GENERATED_BODY()
 
 public:	
+	UAEState(const FObjectInitializer& ObjectInitializer);
+
     virtual UWorld* GetWorld() const override;
     
 	UFUNCTION(BlueprintCallable, Category = "State")
@@ -23,6 +27,95 @@ public:
 
     UFUNCTION(BlueprintCallable, Category = "State")
     void GotoState(TSubclassOf<UAEState> StateClass);
+
+	template<typename T>
+	void GotoState();
+
+	/**
+	Sets a timer that's tracked by this state and cleared when the state becomes inactive.
+	Clearing only touches this state's own timers, unlike clearing all timers for the object.
+	*/
+	void SetStateTimer(FTimerHandle& InOutHandle, const FTimerDelegate& Delegate, float Rate, bool bLoop = false, float FirstDelay = -1.f);
+
+	template<class UserClass>
+	void SetStateTimer(FTimerHandle& InOutHandle, UserClass * Object, typename FTimerDelegate::TUObjectMethodDelegate<UserClass>::FMethodPtr Method, float Rate, bool bLoop = false, float FirstDelay = -1.f);
+
+	/**
+	Calls Callback next tick unless the state becomes inactive first.  Tracked like SetStateTimer.
+	*/
+	void SetStateTimerForNextTick(TFunction<void()> Callback);
+
+	/**
+	Blueprint version of SetStateTimer.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "State", meta = (DisplayName = "Set State Timer by Event"))
+	FTimerHandle SetStateTimerByEvent(FTimerDynamicDelegate Event, float Time, bool bLooping);
+
+	UFUNCTION(BlueprintCallable, Category = "State")
+	void ClearStateTimer(UPARAM(ref) FTimerHandle& Handle);
+
+	/**
+	If true, becoming inactive also clears every timer bound to this object in the world, including ones not set with SetStateTimer.
+	That's how states have always behaved, so it's on by default.
+	It searches all timers in the world though, so turn it off for states that only set timers with SetStateTimer, SetStateTimerByEvent and the Wait functions,
+	those are cleared without the search either way.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "State")
+	bool bClearAllObjectTimersOnInactive;
+
+	/**
+	Dense id of a state class, assigned the first time a state manager is initialized with it.
+	Ids are shared across all managers so they index flat lookup tables.
+	*/
+	static int32 GetStateClassId(UClass * StateClass);
+
+	/**
+	Override to have a block of plain old data included in UAEStateManager snapshots, like counters the state keeps.
+	Return memory owned by the state that stays valid for the state's lifetime, it's fetched once in Initialize and then just memcpy'd.
+	Restoring a snapshot copies straight back into it without calling any state functions.
+	*/
+	virtual uint8 * GetSnapshotData(int32& OutSize);
+
+public:
+	/////////////////////////////////////// 
+	//Latent execution
+	//These let a state run as a sequence of waits from OnBegin instead of polling in Tick.
+	//Waits are latent actions owned by the state and are destroyed without continuing when the state becomes inactive.
+	//They're updated by the world's latent action manager so the state can turn off bWantsTick.
+
+	/**
+	Sends an event to this state that resumes anything waiting on it with WaitForStateEvent.
+	Route named anim notifies here through UAEStateManager::SendStateEvent to wait on them by notify name.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "State|Latent")
+	void SendStateEvent(FName EventName);
+
+	UFUNCTION(BlueprintCallable, Category = "State|Latent", meta = (Latent, LatentInfo = "LatentInfo", DisplayName = "Wait For Delay"))
+	void K2_WaitForDelay(float Duration, FLatentActionInfo LatentInfo);
+
+	/**
+	Resumes when Montage is no longer playing on AnimInstance.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "State|Latent", meta = (Latent, LatentInfo = "LatentInfo", DisplayName = "Wait For Montage End"))
+	void K2_WaitForMontageEnd(UAnimMontage * Montage, UAnimInstance * AnimInstance, FLatentActionInfo LatentInfo);
+
+	UFUNCTION(BlueprintCallable, Category = "State|Latent", meta = (Latent, LatentInfo = "LatentInfo", DisplayName = "Wait For State Event"))
+	void K2_WaitForStateEvent(FName EventName, FLatentActionInfo LatentInfo);
+
+	/**
+	C++ versions of the waits above that call Continuation when done.
+	Continuation runs on the tick after the wait finishes, and not at all if the state becomes inactive in between.
+	*/
+	void WaitForDelay(float Duration, TFunction<void()> Continuation);
+
+	void WaitForMontageEnd(UAnimMontage * Montage, UAnimInstance * AnimInstance, TFunction<void()> Continuation);
+
+	void WaitForStateEvent(FName EventName, TFunction<void()> Continuation);
+
+	/**
+	Number of times an event was sent since the state began.  Used by the waits.
+	*/
+	int32 GetStateEventCount(FName EventName) const;
 		
 protected:
     /**
@@ -40,6 +133,48 @@ protected:
 	UFUNCTION(BlueprintNativeEvent, Category = "State")
 	bool AllowInterruptionByState(UAEState * State);
 
+public:
+	/**
+	If true, AllowInterruptionByState is never called for this state.
+	Instead the state manager precomputes the answer for every pair of its states from the static rules below
+	when it's initialized, and checks a single bit.
+	Leave this false for states whose AllowInterruptionByState depends on runtime data.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "State|Interruption")
+	bool bUseStaticInterruptionRules;
+
+	/**
+	With static rules, states with an equal or higher priority can interrupt this one unless the allow or deny lists say otherwise.
+	This is also used when this state is the one interrupting a state that uses static rules.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "State|Interruption")
+	int32 InterruptionPriority;
+
+	/**
+	With static rules, states of these classes or their subclasses can always interrupt this one.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "State|Interruption")
+	TArray<TSubclassOf<UAEState>> AllowedInterruptingStates;
+
+	/**
+	With static rules, states of these classes or their subclasses can never interrupt this one.  Takes precedence over AllowedInterruptingStates.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "State|Interruption")
+	TArray<TSubclassOf<UAEState>> DeniedInterruptingStates;
+
+	/**
+	Evaluates the static interruption rules.  Used by the state manager to build its interruption matrix.
+	*/
+	bool EvaluateStaticInterruptionRules(const UAEState * State) const;
+
+	/**
+	Index of this state in the owning manager's StateInstances.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "State")
+	int32 GetStateIndex() const;
+
+protected:
+
 	/**
 	Actions that happen when a state begins.
 	*/
@@ -61,7 +196,7 @@ protected:
     /**
     Actions that happen when a state becomes inactive (AKA stops)
     This gets called after OnInterrupt if a state is being interrupted.
-    Don't try to set any timers here, they'll all be cleared after.
+    Don't try to set any timers here, state timers and, if bClearAllObjectTimersOnInactive is set, all of the state's timers are cleared after.
     */
     UFUNCTION(BlueprintNativeEvent, Category = "State")
     void OnBeComeInactive();
@@ -72,6 +207,31 @@ protected:
 	*/
 	UFUNCTION(BlueprintNativeEvent, Category = "State")
 	void Tick(float DeltaTime);
+
+public:
+	/**
+	Set to false for event driven states that never need to tick.
+	The state manager and AAEStateTickManager skip these without calling into Tick at all.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "State")
+	bool bWantsTick;
+
+	/**
+	Seconds between ticks, 0 ticks every frame.
+	DeltaTime passed to Tick is the time accumulated since the last tick.
+	The first tick after a state begins is staggered so states with the same interval spread out across frames.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "State", meta = (ClampMin = "0.0"))
+	float TickInterval;
+
+	/**
+	Set this on states whose Tick only touches the state's own data and can run off the game thread.
+	AAEStateTickManager can then tick all states of this class in parallel.
+	The Tick must be native and must not transition states.
+	Tick_Implementation is called directly on worker threads, so classes overriding Tick in Blueprint are ticked on the game thread instead.
+	*/
+	UPROPERTY(EditDefaultsOnly, Category = "State")
+	bool bTickIsThreadSafe;
 		
 protected:
 
@@ -81,8 +241,78 @@ protected:
 	*/
     UPROPERTY(BlueprintReadWrite, meta = (BlueprintProtected))
 	bool bIsActive;
+
+	/**
+	Set by the state manager when the state is spawned.
+	*/
+	int32 StateIndex;
+
+	/**
+	Only meaningful on the class default object, see GetStateClassId.
+	*/
+	int32 StateClassId;
+
+	/**
+	Timers set with SetStateTimer while the state is active.
+	*/
+	TArray<FTimerHandle> StateTimerHandles;
+
+	/**
+	StateTimerHandles is compacted when it reaches this size so handles of one shot timers that already fired don't pile up in long running states.
+	*/
+	int32 StateTimerHandlesCompactSize;
+
+	/**
+	Adds a handle to StateTimerHandles, dropping handles of finished timers first if the array grew enough.
+	*/
+	void TrackStateTimer(const FTimerHandle& Handle);
+
+	void ClearStateTimers();
+
+	TMap<FName, int32> StateEventCounts;
+
+	/**
+	UUID for native waits that don't come with an FLatentActionInfo.
+	*/
+	int32 NextNativeLatentUUID;
+
+	/**
+	Incremented by ClearLatentActions.  Waits started before that finish without triggering on their next update.
+	*/
+	uint32 WaitGeneration;
+
+	/**
+	Removes any pending waits and events.
+	Only the waits started with the Wait functions, other latent actions like Blueprint Delay nodes are left alone.
+	*/
+	void ClearLatentActions();
+
+	/**
+	Real time accumulated towards the next tick when TickInterval is used.
+	*/
+	float TimeSinceLastTick;
+
+	/**
+	How much sooner than TickInterval the first interval tick after the state begins happens, for staggering.
+	Kept apart from TimeSinceLastTick so the DeltaTime passed to Tick is still only real time.
+	*/
+	float TickPhase;
+
+	/**
+	Called by the state manager when the state begins to stagger the first interval tick.
+	*/
+	void ResetTickInterval();
+
+	/**
+	Accumulates DeltaTime and returns true if the state should tick this frame.
+	@param OutTickDeltaTime The DeltaTime to pass to Tick
+	*/
+	bool ShouldTick(float DeltaTime, float& OutTickDeltaTime);
 	
 	friend UAEStateManager;
+	friend class AAEStateTickManager;
+	friend struct FAEStateLookupTable;
+	friend class FAEStateWaitAction;
 };
 
 FORCEINLINE_DEBUGGABLE UAEStateManager * UAEState::K2_GetOuterUAEStateManager() const
@@ -90,14 +320,63 @@ FORCEINLINE_DEBUGGABLE UAEStateManager * UAEState::K2_GetOuterUAEStateManager()
 	return GetOuterUAEStateManager();
 }
 
+template<typename T>
+FORCEINLINE_DEBUGGABLE void UAEState::GotoState()
+{
+	GotoState(T::StaticClass());
+}
+
+FORCEINLINE_DEBUGGABLE int32 UAEState::GetStateIndex() const
+{
+	return StateIndex;
+}
+
 FORCEINLINE_DEBUGGABLE bool UAEState::GetIsActive() const
 {
     return bIsActive;
 }
 
+FORCEINLINE_DEBUGGABLE bool UAEState::ShouldTick(float DeltaTime, float& OutTickDeltaTime)
+{
+	if (!bWantsTick)
+	{
+		return false;
+	}
+
+	if (TickInterval <= 0.f)
+	{
+		OutTickDeltaTime = DeltaTime;
+		return true;
+	}
+
+	TimeSinceLastTick += DeltaTime;
+
+	if (TimeSinceLastTick + TickPhase < TickInterval)
+	{
+		return false;
+	}
+
+	OutTickDeltaTime = TimeSinceLastTick;
+	TimeSinceLastTick = 0.f;
+	TickPhase = 0.f;
+	return true;
+}
+
 FORCEINLINE_DEBUGGABLE void UAEState::BecomeInactive()
 {
     bIsActive = false;
     OnBeComeInactive();
-    GetWorld()->GetTimerManager().ClearAllTimersForObject(this);
+    ClearStateTimers();
+    ClearLatentActions();
+
+    if (bClearAllObjectTimersOnInactive)
+    {
+        GetWorld()->GetTimerManager().ClearAllTimersForObject(this);
+    }
+}
+
+template<class UserClass>
+FORCEINLINE_DEBUGGABLE void UAEState::SetStateTimer(FTimerHandle& InOutHandle, UserClass * Object, typename FTimerDelegate::TUObjectMethodDelegate<UserClass>::FMethodPtr Method, float Rate, bool bLoop, float FirstDelay)
+{
+	SetStateTimer(InOutHandle, FTimerDelegate::CreateUObject(Object, Method), Rate, bLoop, FirstDelay);
 }
@@ -0,0 +1,368 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Tuple.h"
+
+namespace AEStateMachineDetail
+{
+	/**
+	Finds the index of TState in the TStates type list at compile time.
+	*/
+	template<typename TState, typename... TStates>
+	struct TStateIndex;
+
+	template<typename TState, typename... TStates>
+	struct TStateIndex<TState, TState, TStates...>
+	{
+		static constexpr int32 Value = 0;
+	};
+
+	template<typename TState, typename TOther, typename... TStates>
+	struct TStateIndex<TState, TOther, TStates...>
+	{
+		static constexpr int32 Value = 1 + TStateIndex<TState, TStates...>::Value;
+	};
+}
+
+/**
+Base for states of a TAEStateMachine.  Every callback is a no-op by default so states only need to declare what they use.
+The callbacks aren't virtual, a state "overrides" one by declaring a function with the same name and signature.
+
+The callbacks are templated on the machine type so a state can be declared before the machine that owns it.
+A state can also take the concrete machine type if the states are forward declared and the callback body is defined after all the states:
+
+	struct FChaseState;
+	struct FAttackState;
+	typedef TAEStateMachine<FMyAIContext, FChaseState, FAttackState> FMyAIStateMachine;
+
+	struct FChaseState : public FAENativeState
+	{
+		void Tick(FMyAIStateMachine& Machine, float DeltaTime);
+	};
+
+	struct FAttackState : public FAENativeState
+	{
+	};
+
+	void FChaseState::Tick(FMyAIStateMachine& Machine, float DeltaTime)
+	{
+		if (Machine.GetContext().IsInRange())
+		{
+			Machine.GotoState<FAttackState>();
+		}
+	}
+
+State indices passed to the callbacks are INDEX_NONE when transitioning from or to no state.
+*/
+struct FAENativeState
+{
+	/**
+	Called when the machine is constructed.
+	*/
+	template<typename TMachine>
+	FORCEINLINE void Initialize(TMachine& Machine)
+	{}
+
+	/**
+	Should the state at StateIndex be allowed to interrupt this state mid run?
+	Same meaning as UAEState::AllowInterruptionByState.
+	*/
+	template<typename TMachine>
+	FORCEINLINE bool AllowInterruptionByState(TMachine& Machine, int32 StateIndex)
+	{
+		return true;
+	}
+
+	template<typename TMachine>
+	FORCEINLINE void OnBegin(TMachine& Machine, int32 PreviousStateIndex)
+	{}
+
+	template<typename TMachine>
+	FORCEINLINE void OnInterrupt(TMachine& Machine, int32 InterruptingStateIndex)
+	{}
+
+	template<typename TMachine>
+	FORCEINLINE void OnEnd(TMachine& Machine, int32 NextStateIndex)
+	{}
+
+	template<typename TMachine>
+	FORCEINLINE void OnBecomeInactive(TMachine& Machine)
+	{}
+
+	template<typename TMachine>
+	FORCEINLINE void Tick(TMachine& Machine, float DeltaTime)
+	{}
+};
+
+/**
+Native, header only counterpart to UAEStateManager for C++ only logic where lots of machines transition every frame, like AI or projectiles.
+
+The set of states is fixed at compile time and every state instance is stored inline in the machine, so there's no UObject creation,
+no class to index lookup, and no Blueprint thunks.  Calls to the current state go through a per-callback jump table indexed by the current state index.
+
+Begin, end, interruption, and becoming inactive work exactly like UAEStateManager and UAEState:
+	ForceGotoState calls OnInterrupt and OnBecomeInactive on the current state if it's still active, then OnEnd, then OnBegin on the new state.
+	GotoState is what a state calls when it's done, it becomes inactive first so OnInterrupt isn't called, like UAEState::GotoState.
+	TryGotoState asks AllowInterruptionByState of the current state first.
+
+Each state type must be unique in TStates, the same way each state class must be unique in UAEStateManager::StateClasses.
+*/
+template<typename TContext, typename... TStates>
+class TAEStateMachine
+{
+public:
+	typedef TAEStateMachine<TContext, TStates...> ThisClass;
+
+	static constexpr int32 NumStates = sizeof...(TStates);
+
+	static_assert(NumStates > 0, "TAEStateMachine needs at least one state.");
+
+	explicit TAEStateMachine(TContext& InContext)
+		: Context(InContext),
+		CurrentStateIndex(INDEX_NONE),
+		bIsActive(false)
+	{
+		const FInitializeFunc InitializeFuncs[] = { &CallInitialize<TStates>... };
+
+		for (const FInitializeFunc Func : InitializeFuncs)
+		{
+			Func(*this);
+		}
+	}
+
+	TAEStateMachine(const ThisClass&) = delete;
+	ThisClass& operator=(const ThisClass&) = delete;
+
+	/**
+	Compile time index of a state type.  This is what gets passed around to the state callbacks
+	and it's also a compact value to send over the network.
+	*/
+	template<typename TState>
+	static constexpr int32 GetStateIndex()
+	{
+		return AEStateMachineDetail::TStateIndex<TState, TStates...>::Value;
+	}
+
+	template<typename TState>
+	FORCEINLINE TState& GetState()
+	{
+		return States.template Get<GetStateIndex<TState>()>();
+	}
+
+	template<typename TState>
+	FORCEINLINE const TState& GetState() const
+	{
+		return States.template Get<GetStateIndex<TState>()>();
+	}
+
+	FORCEINLINE TContext& GetContext() const
+	{
+		return Context;
+	}
+
+	FORCEINLINE int32 GetCurrentStateIndex() const
+	{
+		return CurrentStateIndex;
+	}
+
+	template<typename TState>
+	FORCEINLINE bool IsInState() const
+	{
+		return CurrentStateIndex == GetStateIndex<TState>();
+	}
+
+	/**
+	Whether the current state is still running, same as UAEState::GetIsActive on the current state.
+	*/
+	FORCEINLINE bool GetIsActive() const
+	{
+		return bIsActive;
+	}
+
+	/**
+	Ticks the current state if it's active.  It's up to the owner to call this.
+	*/
+	FORCEINLINE void Tick(float DeltaTime)
+	{
+		if (CurrentStateIndex != INDEX_NONE && bIsActive)
+		{
+			static constexpr FTickFunc TickFuncs[] = { &CallTick<TStates>... };
+			TickFuncs[CurrentStateIndex](*this, DeltaTime);
+		}
+	}
+
+	/**
+	Stops the current state without transitioning anywhere, same as UAEState::BecomeInactive.
+	*/
+	FORCEINLINE void BecomeInactive()
+	{
+		if (CurrentStateIndex != INDEX_NONE && bIsActive)
+		{
+			bIsActive = false;
+
+			static constexpr FStateFunc BecomeInactiveFuncs[] = { &CallOnBecomeInactive<TStates>... };
+			BecomeInactiveFuncs[CurrentStateIndex](*this);
+		}
+	}
+
+	/**
+	Transitions to a new state.  Pass INDEX_NONE to go to no state.
+	*/
+	void ForceGotoState(int32 StateIndex)
+	{
+		check(StateIndex >= INDEX_NONE && StateIndex < NumStates);
+
+		if (CurrentStateIndex != INDEX_NONE)
+		{
+			if (bIsActive)
+			{
+				static constexpr FIndexFunc InterruptFuncs[] = { &CallOnInterrupt<TStates>... };
+				InterruptFuncs[CurrentStateIndex](*this, StateIndex);
+
+				BecomeInactive();
+			}
+
+			static constexpr FIndexFunc EndFuncs[] = { &CallOnEnd<TStates>... };
+			EndFuncs[CurrentStateIndex](*this, StateIndex);
+		}
+
+		const int32 PrevStateIndex = CurrentStateIndex;
+
+		CurrentStateIndex = StateIndex;
+
+		if (CurrentStateIndex != INDEX_NONE)
+		{
+			bIsActive = true;
+
+			static constexpr FIndexFunc BeginFuncs[] = { &CallOnBegin<TStates>... };
+			BeginFuncs[CurrentStateIndex](*this, PrevStateIndex);
+		}
+		else
+		{
+			bIsActive = false;
+		}
+	}
+
+	template<typename TState>
+	FORCEINLINE void ForceGotoState()
+	{
+		ForceGotoState(GetStateIndex<TState>());
+	}
+
+	/**
+	Similar to ForceGotoState but calls AllowInterruptionByState first before going to the new state.
+
+	@param bAllowNull if true, allows the switch if StateIndex is INDEX_NONE
+	@return true if AllowInterruptionByState passed and the machine transitioned to the new state
+	*/
+	FORCEINLINE bool TryGotoState(int32 StateIndex, bool bAllowNull = true)
+	{
+		if (!bAllowNull && StateIndex == INDEX_NONE)
+		{
+			return false;
+		}
+
+		if (AllowInterruptionByState(StateIndex))
+		{
+			ForceGotoState(StateIndex);
+			return true;
+		}
+
+		return false;
+	}
+
+	template<typename TState>
+	FORCEINLINE bool TryGotoState()
+	{
+		return TryGotoState(GetStateIndex<TState>());
+	}
+
+	FORCEINLINE bool AllowInterruptionByState(int32 StateIndex)
+	{
+		if (StateIndex == INDEX_NONE)
+		{
+			return true;
+		}
+
+		if (CurrentStateIndex != INDEX_NONE && bIsActive)
+		{
+			static constexpr FAllowFunc AllowFuncs[] = { &CallAllowInterruptionByState<TStates>... };
+			return AllowFuncs[CurrentStateIndex](*this, StateIndex);
+		}
+
+		return true;
+	}
+
+	/**
+	Called by the current state when it's done to move on to another state, same as UAEState::GotoState.
+	The current state becomes inactive first so OnInterrupt isn't called on it.
+	*/
+	FORCEINLINE void GotoState(int32 StateIndex)
+	{
+		BecomeInactive();
+		ForceGotoState(StateIndex);
+	}
+
+	template<typename TState>
+	FORCEINLINE void GotoState()
+	{
+		GotoState(GetStateIndex<TState>());
+	}
+
+private:
+	typedef void(*FInitializeFunc)(ThisClass&);
+	typedef void(*FStateFunc)(ThisClass&);
+	typedef void(*FIndexFunc)(ThisClass&, int32);
+	typedef void(*FTickFunc)(ThisClass&, float);
+	typedef bool(*FAllowFunc)(ThisClass&, int32);
+
+	template<typename TState>
+	static void CallInitialize(ThisClass& Machine)
+	{
+		Machine.template GetState<TState>().Initialize(Machine);
+	}
+
+	template<typename TState>
+	static bool CallAllowInterruptionByState(ThisClass& Machine, int32 StateIndex)
+	{
+		return Machine.template GetState<TState>().AllowInterruptionByState(Machine, StateIndex);
+	}
+
+	template<typename TState>
+	static void CallOnBegin(ThisClass& Machine, int32 PreviousStateIndex)
+	{
+		Machine.template GetState<TState>().OnBegin(Machine, PreviousStateIndex);
+	}
+
+	template<typename TState>
+	static void CallOnInterrupt(ThisClass& Machine, int32 InterruptingStateIndex)
+	{
+		Machine.template GetState<TState>().OnInterrupt(Machine, InterruptingStateIndex);
+	}
+
+	template<typename TState>
+	static void CallOnEnd(ThisClass& Machine, int32 NextStateIndex)
+	{
+		Machine.template GetState<TState>().OnEnd(Machine, NextStateIndex);
+	}
+
+	template<typename TState>
+	static void CallOnBecomeInactive(ThisClass& Machine)
+	{
+		Machine.template GetState<TState>().OnBecomeInactive(Machine);
+	}
+
+	template<typename TState>
+	static void CallTick(ThisClass& Machine, float DeltaTime)
+	{
+		Machine.template GetState<TState>().Tick(Machine, DeltaTime);
+	}
+
+	TContext& Context;
+
+	TTuple<TStates...> States;
+
+	int32 CurrentStateIndex;
+
+	bool bIsActive;
+};
@@ -3,6 +3,193 @@
 #include "AEStateManager.generated.h"
 
 class UAEState;
+class UActorChannel;
+class FOutBunch;
+struct FReplicationFlags;
+
+/**
+Replicated state of a UAEStateManager.  Serialized as two bytes.
+*/
+USTRUCT()
+struct AEFRAMEWORK_API FAEStateManagerNetState
+{
+	GENERATED_USTRUCT_BODY()
+
+	/**
+	StateIndex value that means no state.  This also limits replicated managers to 255 states.
+	*/
+	static const uint8 NO_STATE = MAX_uint8;
+
+	FAEStateManagerNetState()
+		: StateIndex(NO_STATE),
+		TransitionCount(0)
+	{}
+
+	/**
+	Index into the manager's StateInstances.
+	*/
+	UPROPERTY()
+	uint8 StateIndex;
+
+	/**
+	Incremented by the server on every transition and on every rejected prediction so clients get corrected.
+	*/
+	UPROPERTY()
+	uint8 TransitionCount;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap * Map, bool& bOutSuccess)
+	{
+		Ar << StateIndex;
+		Ar << TransitionCount;
+
+		bOutSuccess = true;
+		return true;
+	}
+
+	FORCEINLINE bool operator==(const FAEStateManagerNetState& Other) const
+	{
+		return StateIndex == Other.StateIndex
+			&& TransitionCount == Other.TransitionCount;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FAEStateManagerNetState> : public TStructOpsTypeTraitsBase2<FAEStateManagerNetState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
+
+/**
+What a UAEStateManager last replicated to one actor channel.
+*/
+struct FAEStateManagerChannelInfo
+{
+	FAEStateManagerChannelInfo()
+		: SentVersion(0),
+		UnackedPacketId(INDEX_NONE)
+	{}
+
+	/**
+	NetStateVersion when the net state was last replicated to the channel.
+	*/
+	uint32 SentVersion;
+
+	/**
+	Packet the last write to the channel went out in at the latest, INDEX_NONE once that's acked.
+	*/
+	int32 UnackedPacketId;
+};
+
+/**
+Managers whose state class ids span fewer than this many ids look states up with a flat array instead of a map.
+*/
+const static int32 MAX_FLAT_STATE_LOOKUP_SIZE = 256;
+
+/**
+Fixed part of a UAEStateManager snapshot.  Followed by the snapshot data blocks of the states that have them.
+*/
+struct FAEStateManagerSnapshotHeader
+{
+	int16 CurrentStateIndex;
+	int16 PendingStateIndex;
+	uint8 bCurrentStateActive;
+	uint8 bHasPendingTransition;
+	float TimeSinceLastTick;
+	float TickPhase;
+};
+
+/**
+Snapshot data a state exposed through UAEState::GetSnapshotData.
+*/
+struct FAEStateSnapshotBlock
+{
+	uint8 * Data;
+	int32 Size;
+};
+
+/**
+Class to index lookup and static interruption matrix for a list of state classes.
+Built once per manager archetype on the first Initialize and shared by every manager instance with the same StateClasses,
+so initializing a manager only copies a pointer to it.
+The table lives outside of garbage collection so it only holds weak pointers to the classes, see IsValid.
+*/
+struct AEFRAMEWORK_API FAEStateLookupTable
+{
+	FAEStateLookupTable()
+		: FlatStateLookupBaseClassId(0),
+		bUseFlatStateLookup(false)
+	{}
+
+	static TSharedPtr<const FAEStateLookupTable> Build(const TArray<TSubclassOf<UAEState>>& StateClasses);
+
+	/**
+	Finds the state classes listed more than once in StateClasses, in the order of their second appearance.
+	*/
+	static void FindDuplicateStateClasses(const TArray<TSubclassOf<UAEState>>& StateClasses, TArray<UClass *>& OutDuplicateStateClasses);
+
+	int32 GetStateIndexForClass(UClass * StateClass) const;
+
+	/**
+	False once one of the state classes has been garbage collected, like after a blueprint recompile, and the table needs to be rebuilt.
+	*/
+	bool IsValid() const;
+
+	/**
+	StateClasses without NULL entries and duplicates, in state index order.
+	*/
+	TArray<TWeakObjectPtr<UClass>> UniqueStateClasses;
+
+	/**
+	Classes that were listed more than once.  Only the first one gets a state.
+	*/
+	TArray<TWeakObjectPtr<UClass>> DuplicateStateClasses;
+
+	/**
+	Quick lookup of state name to state index.
+	Only used if the state class ids are too spread out for FlatStateLookup.
+	*/
+	TMap<TWeakObjectPtr<UClass>, int32> StateClassToIndex;
+
+	/**
+	State index for each state class id starting at FlatStateLookupBaseClassId, INDEX_NONE if the class isn't in the list.
+	*/
+	TArray<int8> FlatStateLookup;
+
+	int32 FlatStateLookupBaseClassId;
+
+	bool bUseFlatStateLookup;
+
+	/**
+	Precomputed results of UAEState::EvaluateStaticInterruptionRules on the class defaults.
+	Bit CurrentStateIndex * NumStates + InterruptingStateIndex is set if the interruption is allowed.
+	Only used for states with bUseStaticInterruptionRules.
+	*/
+	TBitArray<> InterruptionMatrix;
+};
+
+UENUM(BlueprintType)
+namespace AEStateTransitionCoalescing
+{
+	enum Type
+	{
+		/**
+		The last transition requested before the pending transition is applied wins.
+		*/
+		LAST_REQUEST_WINS							UMETA(DisplayName = "Last request wins"),
+
+		/**
+		The requested state with the highest UAEState::InterruptionPriority wins, ties go to the later request.
+		Requests to go to no state count as priority 0.
+		*/
+		HIGHEST_PRIORITY_WINS						UMETA(DisplayName = "Highest priority wins"),
+
+		MAX					                        UMETA(Hidden)
+	};
+}
 
 UCLASS(BlueprintType, Blueprintable, DefaultToInstanced, EditInlineNew, Within = Actor)
 class AEFRAMEWORK_API UAEStateManager : public UObject
@@ -33,18 +220,56 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "State")
 	bool Initialize();
 
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	/**
+	Reports duplicate state classes through data validation instead of at runtime.
+	AAEPhysicalActor forwards this to its state managers, other owning actors need to do the same from their own IsDataValid.
+	*/
+	virtual EDataValidationResult IsDataValid(TArray<FText>& ValidationErrors) override;
+#endif // WITH_EDITOR
+
 	/**
-	It's up to the owning actor to call this to tick the current active state.
+	It's up to the owning actor to call this to tick the current active state,
+	unless bTickFromTickManager is set.
 	*/
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "State")
 	void Tick(float DeltaTime);
 
 	/**
 	Transitions to a new state.
+	If bDeferTransitions is set this only queues the transition, see ApplyPendingTransition.
 	*/
 	UFUNCTION(BlueprintCallable, Category = "State")
 	void ForceGotoState(UAEState * State);
 
+	/**
+	If true, transitions aren't applied when they're requested.
+	All requests made during a frame, including ones from inside OnBegin, OnEnd, and Tick, are coalesced into one pending transition
+	which is applied at the end of Tick, so states that would be entered and left in the same frame never run.
+	Requests made while applying the pending transition are applied on the next tick.
+	The manager needs to be ticked by its owner or by AAEStateTickManager for deferred transitions to happen.
+	*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "State")
+	bool bDeferTransitions;
+
+	/**
+	How multiple deferred transition requests in the same frame are resolved.
+	*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "State")
+	TEnumAsByte<AEStateTransitionCoalescing::Type> TransitionCoalescing;
+
+	/**
+	Applies the pending deferred transition if there is one.  Called at the end of Tick.
+	If the pending state is already the current active state, nothing happens instead of restarting it.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "State")
+	void ApplyPendingTransition();
+
+	UFUNCTION(BlueprintCallable, Category = "State")
+	bool HasPendingTransition() const;
+
 	/**
 	Similar to ForceGotoState but this calls AllowInterruptionByState first before going to the new state.
 	
@@ -59,11 +284,23 @@ public:
     
 	UFUNCTION(BlueprintCallable, Category = "State")
 	UAEState * GetCurrentState() const;
+
+	/**
+	Number of transitions this manager has made, including transitions to no state.
+	*/
+	FORCEINLINE uint32 GetTransitionCount() const { return TransitionCount; }
+
+	/**
+	Sends an event to the current state, resuming any UAEState::WaitForStateEvent waiting on it.
+	Owners can forward IAEAnimNotified_Named_Responder::OnNamedAnimNotify here to let states wait on named notifies.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "State")
+	void SendStateEvent(FName EventName);
 	
 	/**
 	Use this to set up all of the states that will be spawned for this manager.
 	Each state should be unique so it can be looked up by class.
-	When making a networked game, just send around the state index being switched to over the network between the different connected players.
+	When making a networked game, set bReplicateStates to have the state index replicated.
 	*/
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "State")
 	TArray<TSubclassOf<UAEState>> StateClasses;
@@ -77,6 +314,152 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "State")
 	UAEState * GetStateForClass(TSubclassOf<UAEState> StateClass) const;
 
+	/**
+	Typed version of GetStateForClass.
+	*/
+	template<typename T>
+	T * GetState() const;
+
+	/**
+	Same as ForceGotoState(GetState<T>()) but does nothing if T isn't one of this manager's states.
+	*/
+	template<typename T>
+	void GotoState();
+
+	/**
+	If true, Initialize registers this manager with the world's AAEStateTickManager
+	which ticks the current state so the owning actor doesn't need to call Tick.
+	*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "State")
+	bool bTickFromTickManager;
+
+	UFUNCTION(BlueprintCallable, Category = "State")
+	void RegisterWithTickManager();
+
+	UFUNCTION(BlueprintCallable, Category = "State")
+	void UnregisterFromTickManager();
+
+	FORCEINLINE bool IsRegisteredWithTickManager() const { return bRegisteredWithTickManager; }
+
+	/**
+	Clears every timer and latent action of every state, including Blueprint Delay nodes, and drops the pending deferred transition.
+	The current state stays current.  AAEActorPool calls this when the owning actor is released.
+	*/
+	void ClearTimersAndLatentActions();
+
+public:
+	/////////////////////////////////////// 
+	//Snapshots
+	//For rollback where the manager is saved and restored many times per frame.
+	//A snapshot holds the current and pending state, the current state's active flag and tick interval time, and the states' opt in snapshot data.
+	//Timers and latent waits aren't part of it.
+
+	/**
+	Size in bytes of this manager's snapshots.  Fixed after Initialize.
+	*/
+	int32 GetSnapshotSize() const;
+
+	/**
+	Writes a snapshot into OutBuffer which must be at least GetSnapshotSize() bytes.
+	*/
+	void SaveSnapshot(uint8 * OutBuffer) const;
+
+	/**
+	Restores a snapshot written by SaveSnapshot.  No state callbacks are called.
+	*/
+	void RestoreSnapshot(const uint8 * Buffer);
+
+	/**
+	Convenience version that resizes OutBuffer, which only allocates the first time if the buffer is reused.
+	*/
+	void SaveSnapshot(TArray<uint8>& OutBuffer) const;
+
+	void RestoreSnapshot(const TArray<uint8>& Buffer);
+
+protected:
+	/**
+	Gathered from UAEState::GetSnapshotData in Initialize.
+	*/
+	TArray<FAEStateSnapshotBlock> StateSnapshotBlocks;
+
+	int32 SnapshotSize;
+
+public:
+	/////////////////////////////////////// 
+	//Networking
+
+	/**
+	If true, the server replicates the current state index to clients and the owning client can predict transitions with PredictGotoState.
+	AAEPhysicalActor replicates the state managers it owns when it's spawned, other owning actors need to call ReplicateNetState from their ReplicateSubobjects.
+	*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "State|Networking")
+	bool bReplicateStates;
+
+	/**
+	On the server, same as TryGotoState.
+	On the owning client, transitions locally right away if AllowInterruptionByState passes and asks the server to do the same.
+	The server corrects the client if it rejects the transition.
+
+	@return true if the transition was allowed locally
+	*/
+	UFUNCTION(BlueprintCallable, Category = "State|Networking")
+	bool PredictGotoState(UAEState * State);
+
+	/**
+	Call from the owning actor's ReplicateSubobjects.
+	Only replicates to a channel while it hasn't been sent the latest net state version,
+	and until the packet of the last write to it is acked and one more call wrote nothing, so a change lost to a NAK is resent.
+	Idle managers therefore aren't compared at all.
+	*/
+	bool ReplicateNetState(UActorChannel * Channel, FOutBunch * Bunch, FReplicationFlags * RepFlags);
+
+	virtual bool IsSupportedForNetworking() const override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual int32 GetFunctionCallspace(UFunction * Function, void * Parameters, FFrame * Stack) override;
+	virtual bool CallRemoteFunction(UFunction * Function, void * Parameters, FOutParmRec * OutParms, FFrame * Stack) override;
+
+protected:
+	UPROPERTY(ReplicatedUsing = OnRep_NetState)
+	FAEStateManagerNetState NetState;
+
+	/**
+	The last prediction from the owning client that the server processed.
+	Only replicated to the owner since other clients never predict.
+	Set when the predicted transition is applied or rejected, so with bDeferTransitions that's in ApplyPendingTransition rather than in ServerPredictGotoState.
+	That way it's replicated in the same update as the NetState change it caused and OnRep_NetState sees both.
+	*/
+	UPROPERTY(Replicated)
+	uint8 AcknowledgedPredictionKey;
+
+	/**
+	Prediction key to acknowledge once the deferred transition it queued is applied.
+	*/
+	uint8 PendingPredictionKey;
+
+	uint8 bHasPendingPredictionKey:1;
+
+	/**
+	Incremented by MarkNetStateDirty.
+	*/
+	uint32 NetStateVersion;
+
+	TMap<TWeakObjectPtr<UActorChannel>, FAEStateManagerChannelInfo> NetStateChannels;
+
+	UFUNCTION()
+	void OnRep_NetState();
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerPredictGotoState(uint8 StateIndex, uint8 PredictionKey);
+
+	/**
+	Key of the last prediction made by the owning client.
+	*/
+	uint8 LocalPredictionKey;
+
+	bool HasNetAuthority() const;
+
+	void MarkNetStateDirty();
+
 protected:
 	UPROPERTY(BlueprintReadOnly, Category = "State")
 	UAEState * CurrentState;
@@ -88,11 +471,34 @@ protected:
 	TArray<UAEState *> StateInstances;
 
 	/**
-	Quick lookup of state name to state index.
+	Shared with the archetype and every other instance that has the same StateClasses.
 	*/
-	TMap<UClass *, int32> StateClassToIndex;
+	TSharedPtr<const FAEStateLookupTable> StateLookup;
+
+	TSharedPtr<const FAEStateLookupTable> GetSharedStateLookup();
+
+	/**
+	The state the pending deferred transition goes to.  NULL is valid if bHasPendingTransition is set.
+	*/
+	UPROPERTY(Transient)
+	UAEState * PendingState;
+
+	bool bHasPendingTransition;
+
+	/**
+	Does the actual transition work for ForceGotoState.
+	*/
+	void PerformGotoState(UAEState * State);
+
+	/**
+	Set by AAEStateTickManager while this manager is registered with it.
+	*/
+	bool bRegisteredWithTickManager;
+
+	uint32 TransitionCount;
 	
 	friend UAEState;
+	friend class AAEStateTickManager;
 };
 
 FORCEINLINE UAEState * UAEStateManager::GetCurrentState() const
@@ -100,6 +506,29 @@ FORCEINLINE UAEState * UAEStateManager::GetCurrentState() const
     return CurrentState;
 }
 
+FORCEINLINE bool UAEStateManager::HasPendingTransition() const
+{
+	return bHasPendingTransition;
+}
+
+template<typename T>
+FORCEINLINE T * UAEStateManager::GetState() const
+{
+	//states are spawned from exactly the class they're looked up by so this can't be a different type
+	return static_cast<T *>(GetStateForClass(T::StaticClass()));
+}
+
+template<typename T>
+FORCEINLINE void UAEStateManager::GotoState()
+{
+	UAEState * State = GetStateForClass(T::StaticClass());
+
+	if (State)
+	{
+		ForceGotoState(State);
+	}
+}
+
 FORCEINLINE UAEState * UAEStateManager::GetStateForIndex(int32 StateIndex) const
 {
     if (StateIndex >= 0)
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "UObject/UObjectBaseUtility.h"
+
+/**
+Per state class profiling of UAEState callbacks.
+Compiled out of shipping builds, and at runtime it's only a branch until ae.StateProfiling is set to 1.
+
+Each profiled callback also opens a cycle counter scope named after the state class so it shows up in the stat profiler.
+Use the AE.DumpStateProfile [N] console command to print the N state classes with the most time,
+and the state managers in the world with the most transitions.
+*/
+#ifndef AE_STATE_PROFILING
+#define AE_STATE_PROFILING !UE_BUILD_SHIPPING
+#endif
+
+#if AE_STATE_PROFILING
+
+namespace AEStateProfileStat
+{
+	enum Type
+	{
+		TICK,
+		BEGIN,
+		END,
+		INTERRUPT,
+
+		MAX
+	};
+}
+
+struct FAEStateClassProfile
+{
+	FAEStateClassProfile()
+	{
+		FMemory::Memzero(Cycles);
+		FMemory::Memzero(Calls);
+	}
+
+	TWeakObjectPtr<UClass> StateClass;
+
+	uint64 Cycles[AEStateProfileStat::MAX];
+	uint32 Calls[AEStateProfileStat::MAX];
+
+	FORCEINLINE uint64 GetTotalCycles() const
+	{
+		uint64 Total = 0;
+
+		for (int32 Stat = 0; Stat < AEStateProfileStat::MAX; ++Stat)
+		{
+			Total += Cycles[Stat];
+		}
+
+		return Total;
+	}
+};
+
+class AEFRAMEWORK_API FAEStateProfiler
+{
+public:
+	/**
+	Value of the ae.StateProfiling console variable.
+	*/
+	static int32 bEnabled;
+
+	/**
+	Adds time to a state class.  Game thread only.
+	*/
+	static void Record(UClass * StateClass, AEStateProfileStat::Type Stat, uint64 Cycles, uint32 Calls = 1);
+
+	static void Reset();
+
+	static const TArray<FAEStateClassProfile>& GetProfiles();
+
+private:
+	/**
+	Indexed by UAEState::GetStateClassId.
+	*/
+	static TArray<FAEStateClassProfile> Profiles;
+};
+
+/**
+Times a scope and records it for StateClass when profiling is enabled.
+*/
+class FAEStateProfileScope
+{
+public:
+	FORCEINLINE FAEStateProfileScope(UClass * InStateClass, AEStateProfileStat::Type InStat, uint32 InCalls = 1)
+		: StateClass(FAEStateProfiler::bEnabled ? InStateClass : NULL),
+		Stat(InStat),
+		Calls(InCalls),
+		StartCycles(StateClass ? FPlatformTime::Cycles64() : 0),
+		CycleCounter(StateClass)
+	{}
+
+	FORCEINLINE ~FAEStateProfileScope()
+	{
+		if (StateClass)
+		{
+			FAEStateProfiler::Record(StateClass, Stat, FPlatformTime::Cycles64() - StartCycles, Calls);
+		}
+	}
+
+private:
+	UClass * StateClass;
+	AEStateProfileStat::Type Stat;
+	uint32 Calls;
+	uint64 StartCycles;
+	FScopeCycleCounterUObject CycleCounter;
+};
+
+#define AE_STATE_PROFILE_SCOPE(StateClass, Stat) FAEStateProfileScope ANONYMOUS_VARIABLE(AEStateProfileScope)(StateClass, AEStateProfileStat::Stat)
+#define AE_STATE_PROFILE_SCOPE_CALLS(StateClass, Stat, Calls) FAEStateProfileScope ANONYMOUS_VARIABLE(AEStateProfileScope)(StateClass, AEStateProfileStat::Stat, Calls)
+
+#else
+
+#define AE_STATE_PROFILE_SCOPE(StateClass, Stat)
+#define AE_STATE_PROFILE_SCOPE_CALLS(StateClass, Stat, Calls)
+
+#endif // AE_STATE_PROFILING
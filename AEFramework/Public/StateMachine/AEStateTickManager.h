@@ -0,0 +1,101 @@
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "AEStateTickManager.generated.h"
+
+class UAEState;
+class UAEStateManager;
+
+/**
+All active states of one class gathered for a frame so they tick back to back.
+*/
+USTRUCT()
+struct FAEStateTickBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UClass * StateClass;
+
+	/**
+	The class sets UAEState::bTickIsThreadSafe and Tick isn't overridden in Blueprint,
+	so Tick_Implementation can be called directly from worker threads without going through ProcessEvent.
+	*/
+	bool bCanTickInParallel;
+
+	/**
+	Frames in a row no state of the class ticked, the bucket is removed after AAEStateTickManager::MAX_IDLE_BUCKET_TICKS.
+	*/
+	int32 NumIdleTicks;
+
+	UPROPERTY()
+	TArray<UAEState *> States;
+
+	/**
+	DeltaTime to tick each state with, they differ when states use UAEState::TickInterval.
+	*/
+	TArray<float> DeltaTimes;
+};
+
+/**
+One per world.  Ticks the current states of every registered UAEStateManager in a single tick function
+so owning actors don't need to tick just to tick their state manager.
+
+States that don't want to tick, or whose TickInterval hasn't elapsed, are skipped while gathering.
+The rest are ticked grouped by state class so the same Tick implementation runs back to back.
+Classes that set UAEState::bTickIsThreadSafe and don't override Tick in Blueprint can be ticked in parallel if bAllowParallelTick is set.
+
+State managers register themselves in Initialize when UAEStateManager::bTickFromTickManager is set.
+Note that this ticks the states directly, so an overridden UAEStateManager::Tick isn't called for registered managers.
+*/
+UCLASS(NotPlaceable, Transient)
+class AEFRAMEWORK_API AAEStateTickManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AAEStateTickManager(const FObjectInitializer& ObjectInitializer);
+
+	virtual void PostInitializeComponents() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void BeginDestroy() override;
+	virtual void Tick(float DeltaTime) override;
+
+	/**
+	Gets the tick manager for a world, spawning it if it doesn't exist yet.
+	Returns NULL instead of spawning one for worlds that aren't game worlds or are being torn down.
+	*/
+	static AAEStateTickManager * Get(UWorld * World);
+
+	void RegisterStateManager(UAEStateManager * StateManager);
+
+	void UnregisterStateManager(UAEStateManager * StateManager);
+
+	/**
+	If true, buckets of states whose class has bTickIsThreadSafe set are ticked with ParallelFor.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State")
+	bool bAllowParallelTick;
+
+	const static int32 MAX_IDLE_BUCKET_TICKS = 300;
+
+protected:
+	TArray<TWeakObjectPtr<UAEStateManager>> StateManagers;
+
+	/**
+	Copy of StateManagers the deferred transitions are applied from, reused every frame.
+	*/
+	TArray<TWeakObjectPtr<UAEStateManager>> PendingTransitionManagers;
+
+	/**
+	Reused every frame so gathering states doesn't allocate once the buckets have grown.
+	*/
+	UPROPERTY(Transient)
+	TArray<FAEStateTickBucket> TickBuckets;
+
+	UPROPERTY(Transient)
+	TMap<UClass *, int32> TickBucketIndexForClass;
+
+private:
+	static TArray<AAEStateTickManager *> Instances;
+};
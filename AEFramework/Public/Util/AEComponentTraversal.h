@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+
+namespace AEComponentTraversalOrder
+{
+	enum Type
+	{
+		/**
+		Level order, a component's children are visited after every component closer to the root.
+		*/
+		BREADTH_FIRST,
+
+		/**
+		Pre order, a component's whole subtree is visited before its next sibling.
+		*/
+		DEPTH_FIRST
+	};
+}
+
+/**
+Components the traversal queue or stack holds before it has to allocate.  Covers the component count of most actor heirarchies.
+*/
+const static int32 AE_COMPONENT_TRAVERSAL_INLINE_SIZE = 64;
+
+/**
+Walks the attach children heirarchy under Root, Root included, calling Visitor on each component.
+Have the visitor return true to stop the traversal early.
+
+The visitor is called directly rather than through a std::function, and the queue or stack uses inline storage,
+so this doesn't touch the heap unless the heirarchy has more than AE_COMPONENT_TRAVERSAL_INLINE_SIZE components.
+
+	USceneComponent * Found = TraverseComponents<AEComponentTraversalOrder::DEPTH_FIRST>(Root, [](USceneComponent * Component)
+	{
+		return Component->ComponentHasTag(TEXT("Muzzle"));
+	});
+
+@return the component the visitor stopped on, or NULL if it visited everything
+*/
+template<AEComponentTraversalOrder::Type Order = AEComponentTraversalOrder::BREADTH_FIRST, typename TVisitor>
+FORCEINLINE_DEBUGGABLE USceneComponent * TraverseComponents(USceneComponent * Root, TVisitor&& Visitor)
+{
+	if (!Root)
+	{
+		return NULL;
+	}
+
+	TArray<USceneComponent *, TInlineAllocator<AE_COMPONENT_TRAVERSAL_INLINE_SIZE>> Pending;
+	Pending.Add(Root);
+
+	if (Order == AEComponentTraversalOrder::BREADTH_FIRST)
+	{
+		//visited components stay in the array behind the cursor instead of being removed from the front
+		for (int32 Cursor = 0; Cursor < Pending.Num(); ++Cursor)
+		{
+			USceneComponent * Component = Pending[Cursor];
+
+			if (Visitor(Component))
+			{
+				return Component;
+			}
+
+			Pending.Append(Component->GetAttachChildren());
+		}
+	}
+	else
+	{
+		while (Pending.Num() > 0)
+		{
+			USceneComponent * Component = Pending.Pop(false);
+
+			if (Visitor(Component))
+			{
+				return Component;
+			}
+
+			//pushed in reverse so the first child is visited first
+			const TArray<USceneComponent *>& Children = Component->GetAttachChildren();
+
+			for (int32 ChildInd = Children.Num() - 1; ChildInd >= 0; --ChildInd)
+			{
+				Pending.Add(Children[ChildInd]);
+			}
+		}
+	}
+
+	return NULL;
+}
@@ -0,0 +1,52 @@
+#include "AEEventLogDecodeCommandlet.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "AEEventLog.h"
+
+DEFINE_LOG_CATEGORY_STATIC(AEEventLogDecode, Log, All);
+
+int32 UAEEventLogDecodeCommandlet::Main(const FString& Params)
+{
+	FString InFilename;
+
+	if (!FParse::Value(*Params, TEXT("In="), InFilename))
+	{
+		UE_LOG(AEEventLogDecode, Error, TEXT("AEEventLogDecode needs -In=<EventLogFile>"));
+		return 1;
+	}
+
+	FString OutFilename;
+
+	if (!FParse::Value(*Params, TEXT("Out="), OutFilename))
+	{
+		OutFilename = FPaths::ChangeExtension(InFilename, TEXT("csv"));
+	}
+
+	TArray<uint8> FileData;
+
+	if (!FFileHelper::LoadFileToArray(FileData, *InFilename))
+	{
+		UE_LOG(AEEventLogDecode, Error, TEXT("AEEventLogDecode couldn't read \"%s\""), *InFilename);
+		return 1;
+	}
+
+	FString Csv;
+
+	if (!FAEEventLog::DecodeToCsv(FileData, Csv))
+	{
+		UE_LOG(AEEventLogDecode, Error, TEXT("AEEventLogDecode \"%s\" isn't an event log of version %u"), *InFilename, FAEEventLog::FILE_VERSION);
+		return 1;
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *OutFilename))
+	{
+		UE_LOG(AEEventLogDecode, Error, TEXT("AEEventLogDecode couldn't write \"%s\""), *OutFilename);
+		return 1;
+	}
+
+	UE_LOG(AEEventLogDecode, Display, TEXT("AEEventLogDecode wrote \"%s\""), *OutFilename);
+
+	return 0;
+}
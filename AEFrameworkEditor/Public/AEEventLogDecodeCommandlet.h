@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "AEEventLogDecodeCommandlet.generated.h"
+
+/**
+Decodes a file written by FAEEventLog to CSV.
+
+	UE4Editor-Cmd.exe <Project> -run=AEEventLogDecode -In=<EventLogFile> [-Out=<CsvFile>]
+
+Out defaults to the input file with a .csv extension.
+*/
+UCLASS()
+class AEFRAMEWORKEDITOR_API UAEEventLogDecodeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+};